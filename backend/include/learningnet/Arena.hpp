@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+
+namespace learningnet {
+
+/**
+ * Monotonic memory arena for the transient data of one request or one item
+ * of a batch, used through std::pmr containers.
+ *
+ * Allocating only advances a pointer in the current block of the arena and
+ * deallocating does nothing. All memory is freed at once by #release() or when
+ * the arena is destroyed. An arena must only be used by one thread at a time.
+ */
+class Arena
+{
+private:
+	//! first block, kept by #release(), or nullptr
+	std::unique_ptr<char[]> m_initial;
+
+	std::pmr::monotonic_buffer_resource m_resource; //!< the blocks
+
+	bool m_inScope; //!< whether a Scope of this arena exists
+
+	/**
+	 * Creates an arena whose first block is allocated right away and kept
+	 * when it is released.
+	 *
+	 * @param initialSize size of the first block in bytes
+	 */
+	Arena(std::size_t initialSize, bool)
+		: m_initial{new char[initialSize]}
+		, m_resource{m_initial.get(), initialSize}
+		, m_inScope{false}
+	{}
+
+public:
+	//! size of the first block of an arena in bytes
+	static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+	/**
+	 * Creates an arena that allocates its first block when it is first used.
+	 *
+	 * @param blockSize size of the first block in bytes, later blocks grow
+	 * geometrically
+	 */
+	explicit Arena(std::size_t blockSize = BLOCK_SIZE)
+		: m_initial{nullptr}
+		, m_resource{blockSize}
+		, m_inScope{false}
+	{}
+
+	Arena(const Arena&) = delete;
+	Arena &operator=(const Arena&) = delete;
+
+	/**
+	 * Exclusive use of an arena that is released when the use begins and
+	 * when it ends, see #local().
+	 */
+	class Scope
+	{
+	private:
+		Arena &m_arena; //!< the arena in use
+
+	public:
+		/**
+		 * Releases \p arena and starts using it.
+		 *
+		 * @param arena the arena
+		 * @throws std::logic_error if \p arena is already used by a Scope
+		 */
+		explicit Scope(Arena &arena)
+			: m_arena(arena)
+		{
+			if (m_arena.m_inScope) {
+				throw std::logic_error("Arena is already in use by an enclosing scope.");
+			}
+			m_arena.m_inScope = true;
+			m_arena.release();
+		}
+
+		/**
+		 * Releases the arena, containers using it must be destroyed before.
+		 */
+		~Scope() {
+			m_arena.release();
+			m_arena.m_inScope = false;
+		}
+
+		Scope(const Scope&) = delete;
+		Scope &operator=(const Scope&) = delete;
+
+		/**
+		 * @return memory resource allocating from the arena
+		 */
+		std::pmr::memory_resource *resource() {
+			return m_arena.resource();
+		}
+	};
+
+	/**
+	 * Starts using the arena of the calling thread, whose first block is
+	 * reused by each use such that a thread handling many small jobs does not
+	 * allocate from the heap for them. The arena is released when the
+	 * returned Scope is created and destroyed. Uses must not be nested, since
+	 * the inner one would invalidate the memory of the outer one.
+	 *
+	 * @return the use of the arena of the calling thread
+	 * @throws std::logic_error if the arena of the calling thread is already
+	 * in use
+	 */
+	static Scope local() {
+		static thread_local Arena arena{BLOCK_SIZE, true};
+		return Scope{arena};
+	}
+
+	/**
+	 * @return memory resource allocating from this arena
+	 */
+	std::pmr::memory_resource *resource() {
+		return &m_resource;
+	}
+
+	/**
+	 * Frees all memory allocated from this arena at once. Containers using it
+	 * must not be used afterwards.
+	 */
+	void release() {
+		m_resource.release();
+	}
+};
+
+}
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Pseudo-enum-class encapsulating the ids of the sections of a compiled
+ * learning net.
+ */
+class CompiledSection {
+	public:
+		//! one CompiledNode per node, in the order of node ids
+		static constexpr uint32_t nodes = 1;
+		//! one CompiledArc per arc, in the order of arc ids
+		static constexpr uint32_t arcs = 2;
+		//! CSR adjacency: n+1 uint32_t offsets into #outArcIds, the out-arcs
+		//! of node i are at offsets i to i+1
+		static constexpr uint32_t outArcOffsets = 3;
+		//! CSR adjacency: uint32_t arc indices grouped by source node, in
+		//! descending order for each node
+		static constexpr uint32_t outArcIds = 4;
+		//! interned branch strings: k+1 uint32_t offsets into #branchChars
+		static constexpr uint32_t branchOffsets = 5;
+		//! interned branch strings: characters of all strings
+		static constexpr uint32_t branchChars = 6;
+		//! index of the target node as int32_t, -1 if there is none
+		static constexpr uint32_t target = 7;
+		//! one CompiledSectionEntry per unit node, sorted by section id
+		static constexpr uint32_t sectionIndex = 8;
+		//! uint32_t node indices in topological order, only the nodes that are
+		//! not on or behind a cycle
+		static constexpr uint32_t topologicalOrder = 9;
+		//! uint32_t indices of the nodes without in-arcs
+		static constexpr uint32_t sources = 10;
+		//! uint32_t indices of the out-arcs of test nodes with the highest
+		//! grade, no longer written and ignored when loading since the
+		//! GradeTable finds them
+		static constexpr uint32_t maxGradeArcs = 11;
+};
+
+//! Node record of a compiled learning net.
+struct CompiledNode {
+	int32_t type; //!< type of the node
+	int32_t ref; //!< ref value of the node
+};
+
+//! Arc record of a compiled learning net.
+struct CompiledArc {
+	uint32_t source; //!< index of the source node
+	uint32_t target; //!< index of the target node
+	uint32_t branch; //!< index of the condition branch string
+};
+
+//! Entry of the section index of a compiled learning net.
+struct CompiledSectionEntry {
+	int32_t section; //!< section id of a unit node
+	uint32_t node; //!< index of the unit node
+};
+
+/**
+ * Read-only view of a contiguous array, e.g. a section of a compiled net.
+ */
+template<typename T>
+class ArrayView
+{
+private:
+	const T *m_data; //!< first element
+	std::size_t m_size; //!< number of elements
+
+public:
+	ArrayView() : m_data{nullptr}, m_size{0} {}
+
+	/**
+	 * @param data first element
+	 * @param size number of elements
+	 */
+	ArrayView(const T *data, std::size_t size) : m_data{data}, m_size{size} {}
+
+	const T *begin() const { return m_data; }
+	const T *end() const { return m_data + m_size; }
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	/**
+	 * @param i index of the element
+	 * @return the \p i-th element
+	 */
+	const T &operator[](std::size_t i) const { return m_data[i]; }
+};
+
+/**
+ * Versioned binary format of a learning net that can be used directly from
+ * memory, e.g. from a memory-mapped file, without parsing it element by
+ * element.
+ *
+ * The format starts with a header holding a magic string, the format version,
+ * a byte order mark and the number of sections, followed by one directory
+ * entry per section holding its id, offset and size in bytes. Each section is
+ * an array of plain records (see CompiledSection) and starts at an offset
+ * aligned to 8 bytes. Numbers are stored in the byte order of the machine that
+ * compiled the net, loading rejects nets of a different byte order.
+ * Unknown sections are ignored, such that sections may be added without
+ * breaking older readers.
+ */
+class CompiledNet
+{
+public:
+	//! current version of the format
+	static constexpr uint32_t VERSION = 1;
+
+private:
+	//! magic string at the beginning of every compiled net
+	static constexpr char MAGIC[8] = {'L', 'N', 'N', 'E', 'T', 'B', 'I', 'N'};
+
+	//! written in the byte order of the compiling machine
+	static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	//! Header of a compiled net.
+	struct Header {
+		char magic[8]; //!< #MAGIC
+		uint32_t version; //!< #VERSION
+		uint32_t byteOrder; //!< #BYTE_ORDER_MARK
+		uint32_t sectionCount; //!< number of directory entries
+		uint32_t reserved; //!< padding, 0
+	};
+
+	//! Directory entry of a section of a compiled net.
+	struct SectionEntry {
+		uint32_t id; //!< id of the section, see CompiledSection
+		uint32_t reserved; //!< padding, 0
+		uint64_t offset; //!< offset of the section from the start of the net
+		uint64_t size; //!< size of the section in bytes
+	};
+
+	const char *m_data; //!< the compiled net
+
+	std::size_t m_length; //!< number of bytes in #m_data
+
+	const SectionEntry *m_sections; //!< the directory
+
+	uint32_t m_sectionCount; //!< number of entries in #m_sections
+
+	/**
+	 * @throws std::runtime_error with a message about a corrupt net
+	 */
+	[[noreturn]] static void corrupt(const std::string &reason) {
+		throw std::runtime_error("Compiled network is corrupt: " + reason + ".");
+	}
+
+public:
+	/**
+	 * @param data first byte of a possibly compiled net
+	 * @param length number of bytes in \p data
+	 * @return whether \p data starts like a compiled net
+	 */
+	static bool isCompiled(const char *data, std::size_t length) {
+		return length >= sizeof(MAGIC)
+			&& std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+	}
+
+	/**
+	 * Creates a view of the compiled net at \p data and checks its header and
+	 * directory. The sections themselves are not copied or parsed.
+	 *
+	 * @param data first byte of the compiled net, aligned to 8 bytes and has to
+	 * outlive this CompiledNet
+	 * @param length number of bytes in \p data
+	 * @throws std::runtime_error if \p data is not a compiled net of this
+	 * version and byte order
+	 */
+	CompiledNet(const char *data, std::size_t length)
+		: m_data{data}
+		, m_length{length}
+		, m_sections{nullptr}
+		, m_sectionCount{0}
+	{
+		if (!isCompiled(data, length) || length < sizeof(Header)) {
+			corrupt("header missing");
+		}
+		if (reinterpret_cast<std::uintptr_t>(data) % alignof(SectionEntry) != 0) {
+			corrupt("not aligned");
+		}
+
+		const Header *header = reinterpret_cast<const Header*>(data);
+		if (header->byteOrder != BYTE_ORDER_MARK) {
+			corrupt("compiled with another byte order");
+		}
+		if (header->version != VERSION) {
+			corrupt("version " + std::to_string(header->version) +
+				" instead of " + std::to_string(VERSION));
+		}
+
+		m_sectionCount = header->sectionCount;
+		if ((length - sizeof(Header)) / sizeof(SectionEntry) < m_sectionCount) {
+			corrupt("directory truncated");
+		}
+		m_sections = reinterpret_cast<const SectionEntry*>(data + sizeof(Header));
+		for (uint32_t i = 0; i < m_sectionCount; i++) {
+			const SectionEntry &entry = m_sections[i];
+			if (entry.offset % 8 != 0 || entry.offset > length ||
+					entry.size > length - entry.offset) {
+				corrupt("section " + std::to_string(entry.id) + " out of bounds");
+			}
+		}
+	}
+
+	/**
+	 * @param id id of the section, see CompiledSection
+	 * @return whether the section exists
+	 */
+	bool hasSection(uint32_t id) const {
+		for (uint32_t i = 0; i < m_sectionCount; i++) {
+			if (m_sections[i].id == id) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * @tparam T type of the records of the section
+	 * @param id id of the section, see CompiledSection
+	 * @return the records of the section
+	 * @throws std::runtime_error if the section does not exist or its size is
+	 * no multiple of the record size
+	 */
+	template<typename T>
+	ArrayView<T> section(uint32_t id) const {
+		for (uint32_t i = 0; i < m_sectionCount; i++) {
+			const SectionEntry &entry = m_sections[i];
+			if (entry.id == id) {
+				if (entry.size % sizeof(T) != 0) {
+					corrupt("size of section " + std::to_string(id));
+				}
+				return ArrayView<T>(
+					reinterpret_cast<const T*>(m_data + entry.offset),
+					entry.size / sizeof(T));
+			}
+		}
+		corrupt("section " + std::to_string(id) + " missing");
+	}
+
+	/**
+	 * Writes a compiled net consisting of the given sections.
+	 *
+	 * @param out the stream to which the compiled net is written
+	 * @param sections pairs of section ids and the bytes of the section
+	 */
+	static void write(std::ostream &out,
+			const std::vector<std::pair<uint32_t, std::string>> &sections) {
+		Header header;
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.byteOrder = BYTE_ORDER_MARK;
+		header.sectionCount = sections.size();
+		header.reserved = 0;
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		// Sections follow the directory, each aligned to 8 bytes.
+		uint64_t offset = sizeof(Header) + sections.size() * sizeof(SectionEntry);
+		for (auto &section : sections) {
+			SectionEntry entry;
+			entry.id = section.first;
+			entry.reserved = 0;
+			entry.offset = offset;
+			entry.size = section.second.size();
+			out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+			offset += (entry.size + 7) / 8 * 8;
+		}
+
+		const char padding[8] = {0};
+		for (auto &section : sections) {
+			out.write(section.second.data(), section.second.size());
+			out.write(padding, (8 - section.second.size() % 8) % 8);
+		}
+	}
+
+	/**
+	 * @param records records of a section
+	 * @return the bytes of the section
+	 */
+	template<typename T>
+	static std::string toBytes(const std::vector<T> &records) {
+		return std::string(reinterpret_cast<const char*>(records.data()),
+			records.size() * sizeof(T));
+	}
+};
+
+/**
+ * Read-only memory mapping of a whole file.
+ */
+class MappedFile
+{
+private:
+	const char *m_data; //!< first byte of the mapping
+	std::size_t m_length; //!< number of bytes of the file
+
+public:
+	/**
+	 * Maps the file at \p path into memory.
+	 *
+	 * @param path path of the file
+	 * @throws std::runtime_error if the file cannot be opened or mapped
+	 */
+	explicit MappedFile(const std::string &path)
+		: m_data{nullptr}
+		, m_length{0}
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		struct stat st;
+		if (fd < 0 || ::fstat(fd, &st) < 0) {
+			if (fd >= 0) {
+				::close(fd);
+			}
+			throw std::runtime_error("Could not open file " + path + ".");
+		}
+
+		m_length = st.st_size;
+		if (m_length > 0) {
+			void *data = ::mmap(nullptr, m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) {
+				::close(fd);
+				throw std::runtime_error("Could not map file " + path + ".");
+			}
+			m_data = static_cast<const char*>(data);
+		}
+		::close(fd);
+	}
+
+	/**
+	 * Removes the mapping.
+	 */
+	~MappedFile() {
+		if (m_data) {
+			::munmap(const_cast<char*>(m_data), m_length);
+		}
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile &operator=(const MappedFile&) = delete;
+
+	/**
+	 * @return first byte of the file, page-aligned, or nullptr if it is empty
+	 */
+	const char *data() const {
+		return m_data;
+	}
+
+	/**
+	 * @return number of bytes of the file
+	 */
+	std::size_t size() const {
+		return m_length;
+	}
+};
+
+}
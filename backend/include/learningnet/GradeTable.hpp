@@ -0,0 +1,156 @@
+#pragma once
+
+#include <learningnet/CompiledNet.hpp>
+#include <learningnet/StaticGraph.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace learningnet {
+
+//! Out-arc of a test node together with the grade it requires.
+struct GradedArc {
+	int grade; //!< grade of the out-arc
+	int arc; //!< index of the out-arc in the StaticGraph
+};
+
+/**
+ * Test grades of the out-arcs of all test nodes of a learning net, parsed once
+ * such that learning path searches do not parse them again.
+ *
+ * The out-arcs of each test node are sorted by their grades, out-arcs with
+ * equal grades stay in the order of the StaticGraph. The out-arcs with the
+ * highest grade are found at the end, starting at #maxGradeBegin(). Test nodes
+ * with a grade that is no number have no sorted out-arcs, see #hasGrades().
+ */
+class GradeTable
+{
+private:
+	//! index of the first graded arc of each node id in #m_arcs, followed by
+	//! the number of graded arcs
+	std::vector<int> m_begin;
+
+	//! index of the first graded arc with the highest grade of each node id
+	std::vector<int> m_maxBegin;
+
+	//! whether the grades of each node id are numbers
+	std::vector<bool> m_hasGrades;
+
+	std::vector<GradedArc> m_arcs; //!< graded arcs of all test nodes
+
+	//! node id of the first test node with a grade that is no number, or -1
+	int m_ungradedNode;
+
+public:
+	/**
+	 * Parses the grades of all test nodes. Each distinct grade string is only
+	 * parsed once.
+	 *
+	 * @tparam IsTest function taking a node id and returning whether the node
+	 * is a test node
+	 * @param graph arrays of the nodes and arcs of the net, with branch ids
+	 * @param branchNames the grade string of each branch id
+	 * @param nodeCount number of node ids of the net
+	 * @param isTest whether a node id belongs to a test node
+	 */
+	template<typename IsTest>
+	GradeTable(const StaticGraph &graph,
+			const std::vector<std::string> &branchNames,
+			int nodeCount,
+			const IsTest &isTest)
+		: m_begin(nodeCount + 1, 0)
+		, m_maxBegin(nodeCount, 0)
+		, m_hasGrades(nodeCount, true)
+		, m_arcs{}
+		, m_ungradedNode{-1}
+	{
+		// Parse each branch name once, noting which ones are no numbers.
+		std::vector<int> grade(branchNames.size(), 0);
+		std::vector<bool> isGrade(branchNames.size(), false);
+		auto parse = [&](int branch) {
+			if (!isGrade[branch]) {
+				try {
+					grade[branch] = std::stoi(branchNames[branch]);
+					isGrade[branch] = true;
+				} catch (std::exception&) {
+					return false;
+				}
+			}
+			return true;
+		};
+
+		for (int v = 0; v < nodeCount; v++) {
+			m_begin[v] = m_arcs.size();
+			m_maxBegin[v] = m_arcs.size();
+			if (!isTest(v)) {
+				continue;
+			}
+
+			for (int i = graph.outBegin(v); i < graph.outEnd(v); i++) {
+				if (!parse(graph.branch(i))) {
+					m_hasGrades[v] = false;
+				}
+			}
+			if (!m_hasGrades[v]) {
+				if (m_ungradedNode < 0) {
+					m_ungradedNode = v;
+				}
+				continue;
+			}
+
+			auto first = m_arcs.size();
+			for (int i = graph.outBegin(v); i < graph.outEnd(v); i++) {
+				m_arcs.push_back(GradedArc{grade[graph.branch(i)], i});
+			}
+			std::stable_sort(m_arcs.begin() + first, m_arcs.end(),
+				[](const GradedArc &x, const GradedArc &y) {
+					return x.grade < y.grade;
+				});
+
+			// The highest grade is the grade of the last arc.
+			auto last = m_arcs.size();
+			auto maxBegin = last;
+			while (maxBegin > first && m_arcs[maxBegin - 1].grade == m_arcs[last - 1].grade) {
+				maxBegin--;
+			}
+			m_maxBegin[v] = maxBegin;
+		}
+		m_begin[nodeCount] = m_arcs.size();
+	}
+
+	/**
+	 * @param v node id
+	 * @return whether \p v is no test node or all grades of \p v are numbers
+	 */
+	bool hasGrades(int v) const {
+		return m_hasGrades[v];
+	}
+
+	/**
+	 * @return node id of the first test node with a grade that is no number,
+	 * or -1 if all grades are numbers
+	 */
+	int ungradedNode() const {
+		return m_ungradedNode;
+	}
+
+	/**
+	 * @param v node id of a test node with #hasGrades()
+	 * @return out-arcs of \p v sorted by grade, empty for other nodes
+	 */
+	ArrayView<GradedArc> gradedArcs(int v) const {
+		return ArrayView<GradedArc>(m_arcs.data() + m_begin[v],
+			m_begin[v + 1] - m_begin[v]);
+	}
+
+	/**
+	 * @param v node id of a test node with #hasGrades()
+	 * @return index in #gradedArcs() of the first out-arc of \p v with the
+	 * highest grade
+	 */
+	int maxGradeBegin(int v) const {
+		return m_maxBegin[v] - m_begin[v];
+	}
+};
+
+}
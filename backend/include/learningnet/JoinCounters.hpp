@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Number of activated in-arcs of each join node during a learning path search,
+ * indexed by node ids.
+ *
+ * Each counter is stamped with the epoch in which it was last changed, a
+ * counter with an older stamp counts as 0. Hence, #reset() only starts a new
+ * epoch instead of setting every counter to 0, such that repeated searches do
+ * not pay for the size of the net before they start.
+ */
+class JoinCounters
+{
+private:
+	//! Counter of a single node.
+	struct Counter {
+		uint32_t epoch; //!< epoch in which #count was last changed
+		int32_t count; //!< number of activated in-arcs
+	};
+
+	std::pmr::vector<Counter> m_counters; //!< counter of each node id
+
+	uint32_t m_epoch; //!< current epoch, never 0
+
+public:
+	/**
+	 * Creates counters that are 0 for all nodes.
+	 *
+	 * @param nodeCount number of node ids
+	 * @param resource memory resource of the counters
+	 */
+	explicit JoinCounters(int nodeCount = 0,
+			std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: m_counters(nodeCount, Counter{0, 0}, resource)
+		, m_epoch{1}
+	{}
+
+	/**
+	 * Creates a copy of \p other.
+	 *
+	 * @param other the counters to copy
+	 * @param resource memory resource of the copy
+	 */
+	JoinCounters(const JoinCounters &other, std::pmr::memory_resource *resource)
+		: m_counters(other.m_counters, resource)
+		, m_epoch{other.m_epoch}
+	{}
+
+	/**
+	 * Resets the counters of all nodes to 0.
+	 */
+	void reset() {
+		if (++m_epoch == 0) {
+			// The epoch wrapped around, so old stamps may become current again.
+			for (Counter &counter : m_counters) {
+				counter.epoch = 0;
+			}
+			m_epoch = 1;
+		}
+	}
+
+	/**
+	 * Resets the counter of a node to 0.
+	 *
+	 * @param v node id
+	 */
+	void reset(int v) {
+		m_counters[v] = Counter{m_epoch, 0};
+	}
+
+	/**
+	 * Increments the counter of a node by 1.
+	 *
+	 * @param v node id
+	 * @return the new value of the counter of \p v
+	 */
+	int increment(int v) {
+		Counter &counter = m_counters[v];
+		if (counter.epoch != m_epoch) {
+			counter = Counter{m_epoch, 0};
+		}
+		return ++counter.count;
+	}
+
+	/**
+	 * Decrements the counter of a node by 1, undoing an #increment() since
+	 * the last #reset().
+	 *
+	 * @param v node id
+	 */
+	void decrement(int v) {
+		m_counters[v].count--;
+	}
+
+	/**
+	 * @param v node id
+	 * @return the counter of \p v
+	 */
+	int get(int v) const {
+		const Counter &counter = m_counters[v];
+		return counter.epoch == m_epoch ? counter.count : 0;
+	}
+};
+
+}
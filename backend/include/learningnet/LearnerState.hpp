@@ -0,0 +1,268 @@
+#pragma once
+
+#include <learningnet/LearningNet.hpp>
+#include <learningnet/JoinCounters.hpp>
+#include <memory_resource>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * State of a single learner in a learning net: the type of each node as seen
+ * by the learner (i.e. whether a unit node is inactive, active or completed),
+ * the activated in-arcs of each join node and the recommended learning path.
+ *
+ * The learning net itself is only read, such that one net can be shared by
+ * the states of many learners. All values are stored in vectors indexed by
+ * node ids instead of node maps, since creating a node map registers it with
+ * the net. The vectors sized by the net may come from a memory resource such
+ * as the Arena of a request.
+ */
+class LearnerState
+{
+private:
+	const LearningNet *m_net; //!< learning net this state belongs to
+
+	std::pmr::vector<int> m_type; //!< type of each node for this learner
+
+	//! number of activated in-arcs of each join node
+	JoinCounters m_activatedInArcs;
+
+	//! whether the target was reached by a learning path search
+	bool m_targetReached;
+
+	//! recommended learning path or unit node
+	std::vector<lemon::ListDigraph::Node> m_recommended;
+
+public:
+	/**
+	 * Creates the state of a learner who has not completed any units yet
+	 * beyond those marked as completed in \p net itself.
+	 *
+	 * @param net the learning net, has to outlive this LearnerState
+	 * @param resource memory resource of the types and activated in-arcs
+	 */
+	LearnerState(const LearningNet &net,
+			std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+		: m_net{&net}
+		, m_type(net.maxNodeId() + 1, NodeType::inactive, resource)
+		, m_activatedInArcs(net.maxNodeId() + 1, resource)
+		, m_targetReached{false}
+		, m_recommended{}
+	{
+		for (auto v : net.nodes()) {
+			m_type[net.id(v)] = net.getType(v);
+		}
+	}
+
+	/**
+	 * Creates a copy of \p other.
+	 *
+	 * @param other the state to copy
+	 * @param resource memory resource of the types and activated in-arcs of
+	 * the copy
+	 */
+	LearnerState(const LearnerState &other, std::pmr::memory_resource *resource)
+		: m_net{other.m_net}
+		, m_type(other.m_type, resource)
+		, m_activatedInArcs(other.m_activatedInArcs, resource)
+		, m_targetReached{other.m_targetReached}
+		, m_recommended{other.m_recommended}
+	{}
+
+	// Type Getter and Setter
+	// @{
+
+	/**
+	 * @param v the node
+	 * @return the type of \p v for this learner
+	 */
+	int getType(const lemon::ListDigraph::Node &v) const {
+		return m_type[m_net->id(v)];
+	}
+
+	/**
+	 * Sets the type of a given node for this learner.
+	 *
+	 * @param v the node
+	 * @param type the new type of \p v (preferrably given as a NodeType
+	 * implicitly casted to int)
+	 */
+	void setType(const lemon::ListDigraph::Node &v, int type) {
+		m_type[m_net->id(v)] = type;
+	}
+
+	/**
+	 * @return lemon map assigning to each node its type for this learner
+	 */
+	IdVectorMap<lemon::ListDigraph::Node, int, std::pmr::vector<int>> getTypeMap() const {
+		return IdVectorMap<lemon::ListDigraph::Node, int, std::pmr::vector<int>>{m_type};
+	}
+
+	/**
+	 * Set the type of the unit nodes given by \p completed to completed.
+	 * @param completed section numbers of completed unit nodes
+	 * @return section numbers of completed units for which no unit node could
+	 * be found
+	 */
+	std::vector<int> setCompleted(const std::vector<int> &completed)
+	{
+		// Set type of completed units, looked up in the precomputed index of
+		// the net.
+		std::vector<int> couldNotBeSet;
+		for (int completedSection : completed) {
+			lemon::ListDigraph::Node completedNode = m_net->getUnit(completedSection);
+			if (completedNode != lemon::INVALID) {
+				// Only set it for units, not for connectives!
+				setType(completedNode, NodeType::completed);
+			} else {
+				couldNotBeSet.push_back(completedSection);
+			}
+		}
+
+		return couldNotBeSet;
+	}
+
+	// @}
+	// Helper Functions for Join nodes
+	// @{
+
+	/**
+	 * Resets the activated in-arcs of all join nodes to 0 in constant time.
+	 */
+	void resetActivatedInArcs() {
+		m_activatedInArcs.reset();
+	}
+
+	/**
+	 * Resets the activated in-arcs of a join node to 0.
+	 *
+	 * @param v the join node
+	 */
+	void resetActivatedInArcs(const lemon::ListDigraph::Node &v) {
+		m_activatedInArcs.reset(m_net->id(v));
+	}
+
+	/**
+	 * Increments the activated in-arcs of a join node by 1.
+	 *
+	 * @param v the join node
+	 */
+	void incrementActivatedInArcs(const lemon::ListDigraph::Node &v) {
+		m_activatedInArcs.increment(m_net->id(v));
+	}
+
+	/**
+	 * @param v the join node
+	 * @return activated in-arcs of \p v
+	 */
+	int getActivatedInArcs(const lemon::ListDigraph::Node &v) const {
+		return m_activatedInArcs.get(m_net->id(v));
+	}
+
+	// @}
+	// Target and Recommendation Getters and Setters
+	// @{
+
+	/**
+	 * @return whether the target was reached by a learning path search
+	 */
+	bool isTargetReached() const {
+		return m_targetReached;
+	}
+
+	/**
+	 * Sets whether the target was reached by a learning path search.
+	 *
+	 * @param reached whether the target was reached
+	 */
+	void setTargetReached(bool reached) {
+		m_targetReached = reached;
+	}
+
+	/**
+	 * @return the recommended learning path (or node) for this learner
+	 */
+	const std::vector<lemon::ListDigraph::Node> &getRecommended() const {
+		return m_recommended;
+	}
+
+	/**
+	 * Sets the recommended learning path (or node) for this learner.
+	 *
+	 * @param rec the new recommended learning path (or node)
+	 */
+	void setRecommended(const std::vector<lemon::ListDigraph::Node> &rec) {
+		m_recommended = rec;
+	}
+
+	// @}
+
+	/**
+	 * Writes the learning net with the node types and recommendation of this
+	 * learner in LGF to the stream \p out.
+	 *
+	 * @param out the stream to which the learning net is written
+	 * @param visited optional, mapping from edges to whether that edge was
+	 * visited during a learning path search, also written to \p out if given
+	 */
+	void write(std::ostream &out = std::cout,
+			const IdVectorMap<lemon::ListDigraph::Arc, bool> *visited = nullptr) const {
+		m_net->write(out, getTypeMap(), visited, m_recommended);
+	}
+
+	/**
+	 * Writes only what differs between learners to the stream \p out, as a
+	 * JSON object on one line: the ids of the active nodes under "active",
+	 * the recommended node ids under "recommended" and, if given, the visited
+	 * arcs under "visited".
+	 *
+	 * The visited arcs are written as a bitmap in a string of hexadecimal
+	 * digits. Digit i holds the arcs with ids 4i to 4i+3, the arc with the
+	 * lowest id in the least significant bit.
+	 *
+	 * @param out the stream to which the delta is written
+	 * @param visited optional, mapping from edges to whether that edge was
+	 * visited during a learning path search
+	 */
+	void writeDelta(std::ostream &out = std::cout,
+			const IdVectorMap<lemon::ListDigraph::Arc, bool> *visited = nullptr) const {
+		out << "{\"active\":[";
+		bool first = true;
+		for (int i = 0; i <= m_net->maxNodeId(); i++) {
+			if (m_type[i] == NodeType::active &&
+					m_net->valid(m_net->nodeFromId(i))) {
+				out << (first ? "" : ",") << i;
+				first = false;
+			}
+		}
+
+		out << "],\"recommended\":[";
+		first = true;
+		for (auto v : m_recommended) {
+			out << (first ? "" : ",") << m_net->id(v);
+			first = false;
+		}
+		out << "]";
+
+		if (visited) {
+			std::vector<int> bitmap((m_net->maxArcId() + 4) / 4, 0);
+			for (int i = 0; i <= m_net->maxArcId(); i++) {
+				lemon::ListDigraph::Arc a = m_net->arcFromId(i);
+				if (m_net->valid(a) && (*visited)[a]) {
+					bitmap[i / 4] |= 1 << (i % 4);
+				}
+			}
+
+			const char digits[] = "0123456789abcdef";
+			out << ",\"visited\":\"";
+			for (int digit : bitmap) {
+				out << digits[digit];
+			}
+			out << "\"";
+		}
+		out << "}" << std::endl;
+	}
+};
+
+}
@@ -3,7 +3,17 @@
 #include <lemon/list_graph.h>
 #include <lemon/concepts/digraph.h>
 #include <lemon/lgf_reader.h>
+#include <lemon/connectivity.h>
+#include <learningnet/CompiledNet.hpp>
+#include <learningnet/GradeTable.hpp>
+#include <learningnet/SectionIndex.hpp>
+#include <learningnet/StaticGraph.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <sstream>
+#include <unordered_map>
 
 namespace learningnet {
 
@@ -41,24 +51,185 @@ class NodeType {
 		}
 };
 
+/**
+ * Classes of node types as bit flags, such that a node type is classified by
+ * one lookup in a constant table instead of comparing it to several ranges.
+ *
+ * Types without a NodeType are unknown, additionally those below
+ * NodeType::split count as unit nodes, those between NodeType::test and
+ * NodeType::join as test nodes and all from NodeType::join on as join nodes.
+ */
+class NodeClass {
+	public:
+		static constexpr uint8_t unit = 1 << 0; //!< unit node
+		static constexpr uint8_t split = 1 << 1; //!< split node
+		static constexpr uint8_t condition = 1 << 2; //!< condition node
+		static constexpr uint8_t test = 1 << 3; //!< test node
+		static constexpr uint8_t join = 1 << 4; //!< join node
+		static constexpr uint8_t unknown = 1 << 5; //!< node of unknown type
+
+		//! split, condition or test node, i.e. a node with possibly multiple
+		//! out-arcs
+		static constexpr uint8_t splitLike = split | condition | test;
+
+	private:
+		static constexpr uint8_t unknownUnit = unit | unknown;
+		static constexpr uint8_t unknownTest = test | unknown;
+
+		//! class of each type from NodeType::inactive to NodeType::join
+		static constexpr std::array<uint8_t, NodeType::join + 1> m_classes{{
+			unit, unit, unit, // inactive, active, completed
+			unknownUnit, unknownUnit, unknownUnit, unknownUnit, unknownUnit,
+			unknownUnit, unknownUnit,
+			split, condition, test,
+			unknownTest, unknownTest, unknownTest, unknownTest, unknownTest,
+			unknownTest, unknownTest,
+			join
+		}};
+
+	public:
+		/**
+		 * @param type node type
+		 * @return the classes of \p type
+		 */
+		static constexpr uint8_t of(int type) {
+			return type < NodeType::inactive ? unknownUnit
+				: type >= NodeType::join ? join
+				: m_classes[type];
+		}
+};
+
+//! Type and ref value of a node, stored together such that both are read with
+//! one access.
+struct NodeRecord {
+	int type; //!< type of the node, see NodeType
+	int ref; //!< ref value of the node, its meaning depends on the type
+};
+
+/**
+ * Read-only lemon map assigning to each node of a LearningNet one field of its
+ * NodeRecord.
+ *
+ * @tparam Field the field
+ */
+template<int NodeRecord::*Field>
+class NodeFieldMap
+{
+private:
+	const lemon::ListDigraph::NodeMap<NodeRecord> *m_records; //!< the records
+
+public:
+	using Key = lemon::ListDigraph::Node; //!< key type of this map
+	using Value = int; //!< value type of this map
+
+	/**
+	 * @param records record of each node, has to outlive this map
+	 */
+	explicit NodeFieldMap(const lemon::ListDigraph::NodeMap<NodeRecord> &records)
+		: m_records{&records}
+	{}
+
+	/**
+	 * @param v the node
+	 * @return field of the record of \p v
+	 */
+	Value operator[](const Key &v) const {
+		return (*m_records)[v].*Field;
+	}
+};
+
+/**
+ * Read-only stream buffer over existing memory, such that the memory can be
+ * read as a std::istream without copying it.
+ */
+class MemoryBuffer : public std::streambuf
+{
+public:
+	/**
+	 * @param data first character of the memory
+	 * @param length number of characters in the memory
+	 */
+	MemoryBuffer(const char *data, std::size_t length) {
+		char *begin = const_cast<char*>(data);
+		setg(begin, begin, begin + length);
+	}
+};
+
+/**
+ * Read-only lemon map whose values are stored in a vector indexed by the ids
+ * of the nodes or arcs of a lemon::ListDigraph.
+ *
+ * @tparam K key type, lemon::ListDigraph::Node or lemon::ListDigraph::Arc
+ * @tparam V value type
+ * @tparam Values vector type holding the values
+ */
+template<typename K, typename V, typename Values = std::vector<V>>
+class IdVectorMap
+{
+private:
+	const Values *m_values; //!< values indexed by id
+
+public:
+	using Key = K; //!< key type of this map
+	using Value = V; //!< value type of this map
+
+	/**
+	 * @param values values indexed by id, have to outlive this map
+	 */
+	explicit IdVectorMap(const Values &values) : m_values{&values} {}
+
+	/**
+	 * @param k the node or arc
+	 * @return value of \p k
+	 */
+	Value operator[](const Key &k) const {
+		return (*m_values)[lemon::ListDigraph::id(k)];
+	}
+};
+
 /**
  * Class representing a learning net.
  */
 class LearningNet : public lemon::ListDigraph
 {
 private:
-	lemon::ListDigraph::NodeMap<int> m_type; //!< type of each node
+	lemon::ListDigraph::NodeMap<NodeRecord> m_node; //!< type and ref value of each node
+
+	//! branch id of the condition value or test grade of each edge
+	lemon::ListDigraph::ArcMap<int> m_condition;
 
-	lemon::ListDigraph::NodeMap<int> m_ref; //!< ref value of each node
+	//! condition values and test grades of all edges, indexed by branch id
+	std::vector<std::string> m_branchNames;
 
-	//! condition value or test grade of each edge
-	lemon::ListDigraph::ArcMap<std::string> m_condition;
+	//! mapping from condition values and test grades to their branch ids
+	std::unordered_map<std::string, int> m_branchIds;
 
 	lemon::ListDigraph::Node m_target; //!< target node
 
 	//! recommended learning path or unit node
 	std::vector<lemon::ListDigraph::Node> m_recommended;
 
+	//! whether the members below were computed, see #precompute()
+	bool m_precomputed;
+
+	//! nodes in topological order, without nodes on or behind a cycle
+	std::vector<lemon::ListDigraph::Node> m_topologicalOrder;
+
+	//! whether #m_topologicalOrder contains all nodes
+	bool m_acyclic;
+
+	//! nodes without in-arcs in the order of their ids
+	std::vector<lemon::ListDigraph::Node> m_sources;
+
+	//! unit nodes by section id
+	std::shared_ptr<const SectionIndex> m_sectionIndex;
+
+	//! arrays of the nodes and arcs for read-only traversals
+	std::shared_ptr<const StaticGraph> m_staticGraph;
+
+	//! grades of the out-arcs of test nodes, sorted by grade
+	std::shared_ptr<const GradeTable> m_gradeTable;
+
 	/**
 	 * Sets the ref value of a node.
 	 *
@@ -66,7 +237,95 @@ private:
 	 * @param ref the new ref value
 	 */
 	void setReference(const lemon::ListDigraph::Node &v, int ref) {
-		m_ref[v] = ref;
+		discardPrecomputed();
+		m_node[v].ref = ref;
+	}
+
+	/**
+	 * Discards the members computed by #precompute(), called by every method
+	 * changing this net such that the getters do not answer from stale
+	 * values. Readers still holding the StaticGraph, GradeTable or
+	 * SectionIndex keep their unchanged copies.
+	 */
+	void discardPrecomputed() {
+		if (!m_precomputed) {
+			return;
+		}
+		m_precomputed = false;
+		m_topologicalOrder.clear();
+		m_sources.clear();
+		m_sectionIndex = nullptr;
+		m_staticGraph = nullptr;
+		m_gradeTable = nullptr;
+	}
+
+	/**
+	 * Read-only lemon map assigning to each node of a LearningNet the classes
+	 * of its type, see NodeClass.
+	 */
+	class NodeClassMap
+	{
+	private:
+		const lemon::ListDigraph::NodeMap<NodeRecord> &m_records; //!< the records
+
+	public:
+		using Key = lemon::ListDigraph::Node; //!< key type of this map
+		using Value = uint8_t; //!< value type of this map
+
+		/**
+		 * @param records record of each node
+		 */
+		explicit NodeClassMap(const lemon::ListDigraph::NodeMap<NodeRecord> &records)
+			: m_records(records)
+		{}
+
+		/**
+		 * @param v the node
+		 * @return the classes of the type of \p v
+		 */
+		Value operator[](const Key &v) const {
+			return NodeClass::of(m_records[v].type);
+		}
+	};
+
+	/**
+	 * Read-only lemon map assigning to each arc of a LearningNet its condition
+	 * value or test grade as string.
+	 */
+	class BranchNameMap
+	{
+	private:
+		const LearningNet &m_net; //!< the learning net
+
+	public:
+		using Key = lemon::ListDigraph::Arc; //!< key type of this map
+		using Value = std::string; //!< value type of this map
+
+		/**
+		 * @param net the learning net
+		 */
+		explicit BranchNameMap(const LearningNet &net) : m_net{net} {}
+
+		/**
+		 * @param a the arc
+		 * @return the condition value or test grade of \p a
+		 */
+		Value operator[](const Key &a) const {
+			return m_net.getConditionBranch(a);
+		}
+	};
+
+	/**
+	 * @param branch a condition value or test grade
+	 * @return the branch id of \p branch, which is added to the branch ids of
+	 * this net if it is new
+	 */
+	int internBranch(const std::string &branch) {
+		auto inserted = m_branchIds.emplace(branch, m_branchNames.size());
+		if (inserted.second) {
+			m_branchNames.push_back(branch);
+		}
+		return inserted.first->second;
 	}
 
 	/**
@@ -90,6 +349,261 @@ private:
 		return oss.str();
 	}
 
+	/**
+	 * @return all nodes in the order of their ids
+	 */
+	std::vector<lemon::ListDigraph::Node> sortedNodes() const
+	{
+		std::vector<lemon::ListDigraph::Node> nodeList;
+		for (auto v : nodes()) {
+			nodeList.push_back(v);
+		}
+		std::sort(nodeList.begin(), nodeList.end(),
+			[](lemon::ListDigraph::Node v, lemon::ListDigraph::Node w) {
+				return id(v) < id(w);
+			});
+		return nodeList;
+	}
+
+	/**
+	 * @return nodes without in-arcs in the order of their ids
+	 */
+	std::vector<lemon::ListDigraph::Node> computeSources() const
+	{
+		std::vector<lemon::ListDigraph::Node> sources;
+		for (auto v : sortedNodes()) {
+			if (isSource(v)) {
+				sources.push_back(v);
+			}
+		}
+		return sources;
+	}
+
+	/**
+	 * Sorts the nodes topologically, starting at the sources in the order of
+	 * their ids. Nodes on or behind a cycle are never reached and not
+	 * contained in the result.
+	 *
+	 * @return the topologically sorted nodes
+	 */
+	std::vector<lemon::ListDigraph::Node> computeTopologicalOrder() const
+	{
+		std::vector<int> remainingInArcs(maxNodeId() + 1, 0);
+		for (auto a : arcs()) {
+			remainingInArcs[id(target(a))]++;
+		}
+
+		std::vector<lemon::ListDigraph::Node> order = computeSources();
+		for (std::size_t i = 0; i < order.size(); i++) {
+			for (lemon::ListDigraph::OutArcIt a(*this, order[i]); a != lemon::INVALID; ++a) {
+				lemon::ListDigraph::Node u = target(a);
+				if (--remainingInArcs[id(u)] == 0) {
+					order.push_back(u);
+				}
+			}
+		}
+		return order;
+	}
+
+	/**
+	 * @return pairs of section ids and unit nodes, sorted by section id and
+	 * for equal section ids by node id
+	 */
+	std::vector<std::pair<int, lemon::ListDigraph::Node>> computeSectionIndex() const
+	{
+		std::vector<std::pair<int, lemon::ListDigraph::Node>> sectionIndex;
+		for (auto v : sortedNodes()) {
+			if (isUnit(v)) {
+				sectionIndex.emplace_back(getSection(v), v);
+			}
+		}
+		std::stable_sort(sectionIndex.begin(), sectionIndex.end(),
+			[](const std::pair<int, lemon::ListDigraph::Node> &x,
+			   const std::pair<int, lemon::ListDigraph::Node> &y) {
+				return x.first < y.first;
+			});
+		return sectionIndex;
+	}
+
+	/**
+	 * @param compiled the compiled net
+	 * @param id id of a section of node or arc indices
+	 * @param size number of nodes or arcs
+	 * @return the indices of the section
+	 * @throws std::runtime_error if an index is not smaller than \p size
+	 */
+	static ArrayView<uint32_t> indexSection(const CompiledNet &compiled,
+			uint32_t id, std::size_t size)
+	{
+		ArrayView<uint32_t> indices = compiled.section<uint32_t>(id);
+		for (uint32_t index : indices) {
+			if (index >= size) {
+				throw std::runtime_error("Compiled network is corrupt: index out of bounds.");
+			}
+		}
+		return indices;
+	}
+
+	/**
+	 * Adds the nodes and arcs of a compiled net to this empty LearningNet.
+	 * Nodes and arcs are added in the order of their ids, such that they get
+	 * the same ids as in the net that was compiled.
+	 *
+	 * @param compiled the compiled net
+	 * @throws std::runtime_error if \p compiled is corrupt
+	 */
+	void load(const CompiledNet &compiled)
+	{
+		ArrayView<CompiledNode> nodes =
+			compiled.section<CompiledNode>(CompiledSection::nodes);
+		ArrayView<CompiledArc> arcs =
+			compiled.section<CompiledArc>(CompiledSection::arcs);
+		ArrayView<uint32_t> branchOffsets =
+			compiled.section<uint32_t>(CompiledSection::branchOffsets);
+		ArrayView<char> branchChars =
+			compiled.section<char>(CompiledSection::branchChars);
+		ArrayView<int32_t> target =
+			compiled.section<int32_t>(CompiledSection::target);
+
+		reserveNode(nodes.size());
+		reserveArc(arcs.size());
+		for (const CompiledNode &node : nodes) {
+			lemon::ListDigraph::Node v = addNode();
+			m_node[v] = NodeRecord{node.type, node.ref};
+		}
+
+		// The branch strings are interned, create each string only once.
+		std::vector<int> branchIds;
+		for (std::size_t i = 0; i + 1 < branchOffsets.size(); i++) {
+			if (branchOffsets[i] > branchOffsets[i + 1] ||
+					branchOffsets[i + 1] > branchChars.size()) {
+				throw std::runtime_error("Compiled network is corrupt: branch out of bounds.");
+			}
+			branchIds.push_back(internBranch(std::string(
+				branchChars.begin() + branchOffsets[i],
+				branchOffsets[i + 1] - branchOffsets[i])));
+		}
+
+		for (const CompiledArc &arc : arcs) {
+			if (arc.source >= nodes.size() || arc.target >= nodes.size() ||
+					arc.branch >= branchIds.size()) {
+				throw std::runtime_error("Compiled network is corrupt: arc out of bounds.");
+			}
+			lemon::ListDigraph::Arc a =
+				addArc(nodeFromId(arc.source), nodeFromId(arc.target));
+			m_condition[a] = branchIds[arc.branch];
+		}
+
+		if (target.empty() || target[0] >= static_cast<int32_t>(nodes.size())) {
+			throw std::runtime_error("Compiled network is corrupt: target out of bounds.");
+		}
+		m_target = target[0] < 0 ? lemon::INVALID : nodeFromId(target[0]);
+
+		// The StaticGraph is built from the out-arcs in CSR form, which lists
+		// the out-arcs of each node in the order in which OutArcIt visits
+		// them in this net.
+		ArrayView<uint32_t> outArcOffsets =
+			compiled.section<uint32_t>(CompiledSection::outArcOffsets);
+		ArrayView<uint32_t> outArcIds =
+			compiled.section<uint32_t>(CompiledSection::outArcIds);
+		checkOutArcs(outArcOffsets, outArcIds, nodes.size(), arcs);
+		auto staticGraph = std::make_shared<const StaticGraph>(
+			outArcOffsets, outArcIds,
+			[&](uint32_t a) { return arcs[a].target; },
+			[&](uint32_t a) { return branchIds[arcs[a].branch]; },
+			[&](uint32_t v) { return NodeClass::of(nodes[v].type); },
+			[&](uint32_t v) { return nodes[v].ref; });
+
+		// Take the precomputed members from the compiled net if it has them.
+		if (!compiled.hasSection(CompiledSection::topologicalOrder) ||
+				!compiled.hasSection(CompiledSection::sources) ||
+				!compiled.hasSection(CompiledSection::sectionIndex)) {
+			precompute(std::move(staticGraph));
+			return;
+		}
+
+		m_topologicalOrder.clear();
+		for (uint32_t v : indexSection(compiled,
+				CompiledSection::topologicalOrder, nodes.size())) {
+			m_topologicalOrder.push_back(nodeFromId(v));
+		}
+		m_acyclic = m_topologicalOrder.size() == nodes.size();
+
+		m_sources.clear();
+		for (uint32_t v : indexSection(compiled,
+				CompiledSection::sources, nodes.size())) {
+			m_sources.push_back(nodeFromId(v));
+		}
+
+		std::vector<std::pair<int, int>> units;
+		for (const CompiledSectionEntry &entry : compiled.section<CompiledSectionEntry>(
+				CompiledSection::sectionIndex)) {
+			if (entry.node >= nodes.size()) {
+				throw std::runtime_error("Compiled network is corrupt: index out of bounds.");
+			}
+			units.emplace_back(entry.section, entry.node);
+		}
+		m_sectionIndex = std::make_shared<const SectionIndex>(nodes.size(), std::move(units));
+
+		m_staticGraph = std::move(staticGraph);
+		m_gradeTable = std::make_shared<const GradeTable>(buildGradeTable(*m_staticGraph));
+		m_precomputed = true;
+	}
+
+	/**
+	 * Checks whether the out-arcs of a compiled net in CSR form list each arc
+	 * exactly once under its source node.
+	 *
+	 * @param outArcOffsets offsets into \p outArcIds, one per node followed by
+	 * the number of out-arcs
+	 * @param outArcIds arc indices grouped by source node
+	 * @param nodeCount number of nodes of the compiled net
+	 * @param arcs arcs of the compiled net
+	 * @throws std::runtime_error if that is not the case
+	 */
+	static void checkOutArcs(const ArrayView<uint32_t> &outArcOffsets,
+			const ArrayView<uint32_t> &outArcIds,
+			std::size_t nodeCount,
+			const ArrayView<CompiledArc> &arcs)
+	{
+		if (outArcOffsets.size() != nodeCount + 1 || outArcOffsets[0] != 0 ||
+				outArcOffsets[outArcOffsets.size() - 1] != outArcIds.size() ||
+				outArcIds.size() != arcs.size()) {
+			throw std::runtime_error("Compiled network is corrupt: out-arcs do not match arcs.");
+		}
+
+		std::vector<bool> listed(arcs.size(), false);
+		for (std::size_t v = 0; v + 1 < outArcOffsets.size(); v++) {
+			if (outArcOffsets[v] > outArcOffsets[v + 1]) {
+				throw std::runtime_error("Compiled network is corrupt: out-arc offsets decrease.");
+			}
+			for (uint32_t i = outArcOffsets[v]; i < outArcOffsets[v + 1]; i++) {
+				uint32_t a = outArcIds[i];
+				if (a >= arcs.size() || listed[a] || arcs[a].source != v) {
+					throw std::runtime_error("Compiled network is corrupt: out-arcs do not match arcs.");
+				}
+				listed[a] = true;
+			}
+		}
+	}
+
+	/**
+	 * Like #precompute(), but takes the StaticGraph instead of building it.
+	 *
+	 * @param staticGraph arrays of the current nodes and arcs of this net, as
+	 * given by #buildStaticGraph()
+	 */
+	void precompute(std::shared_ptr<const StaticGraph> staticGraph) {
+		m_topologicalOrder = computeTopologicalOrder();
+		m_acyclic = m_topologicalOrder.size() ==
+			static_cast<std::size_t>(lemon::countNodes(*this));
+		m_sources = computeSources();
+		m_sectionIndex = std::make_shared<const SectionIndex>(buildSectionIndex());
+		m_staticGraph = std::move(staticGraph);
+		m_gradeTable = std::make_shared<const GradeTable>(buildGradeTable(*m_staticGraph));
+		m_precomputed = true;
+	}
+
 public:
 
 	/**
@@ -97,12 +611,23 @@ public:
 	 */
 	LearningNet()
 		: lemon::ListDigraph()
-		, m_type{*this}
-		, m_ref{*this}
-		, m_condition{*this}
+		, m_node{*this, NodeRecord{0, 0}}
+		, m_condition{*this, 0}
+		, m_branchNames{}
+		, m_branchIds{}
 		, m_target{lemon::INVALID}
 		, m_recommended{std::vector<lemon::ListDigraph::Node>()}
-		{}
+		, m_precomputed{false}
+		, m_topologicalOrder{}
+		, m_acyclic{false}
+		, m_sources{}
+		, m_sectionIndex{nullptr}
+		, m_staticGraph{nullptr}
+		, m_gradeTable{nullptr}
+		{
+			// Arcs without a condition value or test grade have branch id 0.
+			internBranch("");
+		}
 
 	/**
 	 * Creates a new LearningNet.
@@ -112,20 +637,72 @@ public:
 	 * @param network this learning net represented in LGF
 	 * @throws lemon::ParserException if the reading of \p networks fails
 	 */
-	LearningNet(const std::string &network) : LearningNet()
+	LearningNet(const std::string &network)
+		: LearningNet(network.data(), network.size())
+		{}
+
+	/**
+	 * Creates a new LearningNet without copying its representation, which is
+	 * either LGF or a compiled net as written by #compile().
+	 *
+	 * The attribute "recommended" is not read.
+	 *
+	 * @param network this learning net represented in LGF or compiled
+	 * @param length number of characters in \p network
+	 * @throws lemon::ParserException if the reading of \p networks fails
+	 * @throws std::runtime_error if \p network is a corrupt compiled net
+	 */
+	LearningNet(const char *network, std::size_t length) : LearningNet()
 	{
+		if (CompiledNet::isCompiled(network, length)) {
+			if (reinterpret_cast<std::uintptr_t>(network) % 8 == 0) {
+				load(CompiledNet(network, length));
+			} else {
+				// Records of compiled nets have to be aligned.
+				std::vector<uint64_t> aligned((length + 7) / 8);
+				std::memcpy(aligned.data(), network, length);
+				load(CompiledNet(reinterpret_cast<const char*>(aligned.data()), length));
+			}
+			return;
+		}
+
 		// Read lemon graph file given as arg.
-		std::istringstream networkIss(network);
+		MemoryBuffer networkBuf(network, length);
+		std::istream networkIss(&networkBuf);
+		lemon::ListDigraph::NodeMap<int> types{*this};
+		lemon::ListDigraph::NodeMap<int> refs{*this};
+		lemon::ListDigraph::ArcMap<std::string> conditions{*this};
 		lemon::DigraphReader<lemon::ListDigraph>(*this, networkIss)
-			.nodeMap("type", m_type)
-			.nodeMap("ref", m_ref)
-			.arcMap("condition", m_condition)
+			.nodeMap("type", types)
+			.nodeMap("ref", refs)
+			.arcMap("condition", conditions)
 			.node("target", m_target)
 			// Do not read attribute "recommended".
 			// It may be set by the Recommender, the old value is not relevant.
 			.run();
+
+		for (auto v : nodes()) {
+			m_node[v] = NodeRecord{types[v], refs[v]};
+		}
+
+		// Intern the branches in the order of the arcs in the LGF.
+		for (int a = 0; a <= maxArcId(); a++) {
+			m_condition[arcFromId(a)] = internBranch(conditions[arcFromId(a)]);
+		}
+		precompute();
 	};
 
+	/**
+	 * Creates a new LearningNet from a compiled net as written by #compile().
+	 *
+	 * @param compiled the compiled net
+	 * @throws std::runtime_error if \p compiled is corrupt
+	 */
+	explicit LearningNet(const CompiledNet &compiled) : LearningNet()
+	{
+		load(compiled);
+	}
+
 	/**
 	 * Creates a new LearningNet with one unit node for each section id in \p
 	 * sections. The successor of each of these unit nodes is a join node with
@@ -173,6 +750,247 @@ public:
 		return a == lemon::INVALID;
 	}
 
+	// Precomputed Structure
+	// @{
+
+	/**
+	 * Computes the topological order, the sources, the mapping from section
+	 * ids to unit nodes, the out-arcs with the highest grade of each test
+	 * node and a StaticGraph once, such that they do not have to be recomputed
+	 * for every learner.
+	 *
+	 * This is done when a net is read. Afterwards, the getters below answer
+	 * from the stored values until the net is changed, which discards them
+	 * until this method is called again. Nets that are not precomputed compute
+	 * the values on each call.
+	 */
+	void precompute() {
+		precompute(std::make_shared<const StaticGraph>(buildStaticGraph()));
+	}
+
+	/**
+	 * @return whether #precompute() was called for this net and it was not
+	 * changed since
+	 */
+	bool isPrecomputed() const {
+		return m_precomputed;
+	}
+
+	/**
+	 * @return arrays of the nodes and arcs of this net for read-only
+	 * traversals
+	 */
+	std::shared_ptr<const StaticGraph> getStaticGraph() const {
+		return m_precomputed ? m_staticGraph :
+			std::make_shared<const StaticGraph>(buildStaticGraph());
+	}
+
+	/**
+	 * @return new arrays of the current nodes and arcs of this net with their
+	 * branch ids, independent of #precompute()
+	 */
+	StaticGraph buildStaticGraph() const {
+		return StaticGraph(*this, m_condition, NodeClassMap{m_node},
+			NodeFieldMap<&NodeRecord::ref>{m_node});
+	}
+
+	/**
+	 * @return the grades of the out-arcs of test nodes, referring to the
+	 * out-arcs of #getStaticGraph()
+	 */
+	std::shared_ptr<const GradeTable> getGradeTable() const {
+		return m_precomputed ? m_gradeTable :
+			std::make_shared<const GradeTable>(buildGradeTable(*getStaticGraph()));
+	}
+
+	/**
+	 * @param graph arrays of the current nodes and arcs of this net with their
+	 * branch ids
+	 * @return new grades of the out-arcs of test nodes in \p graph,
+	 * independent of #precompute()
+	 */
+	GradeTable buildGradeTable(const StaticGraph &graph) const {
+		return GradeTable(graph, m_branchNames, maxNodeId() + 1,
+			[this](int v) { return isTest(nodeFromId(v)); });
+	}
+
+	/**
+	 * @return the unit nodes of this net by section id
+	 */
+	std::shared_ptr<const SectionIndex> getSectionIndex() const {
+		return m_precomputed ? m_sectionIndex :
+			std::make_shared<const SectionIndex>(buildSectionIndex());
+	}
+
+	/**
+	 * @return new index of the current unit nodes of this net by section id,
+	 * independent of #precompute()
+	 */
+	SectionIndex buildSectionIndex() const {
+		std::vector<std::pair<int, int>> units;
+		for (auto v : nodes()) {
+			if (isUnit(v)) {
+				units.emplace_back(getSection(v), id(v));
+			}
+		}
+		return SectionIndex(maxNodeId() + 1, std::move(units));
+	}
+
+	/**
+	 * @return nodes in topological order, without nodes on or behind a cycle
+	 */
+	std::vector<lemon::ListDigraph::Node> getTopologicalOrder() const {
+		return m_precomputed ? m_topologicalOrder : computeTopologicalOrder();
+	}
+
+	/**
+	 * @return whether this net is acyclic
+	 */
+	bool isAcyclic() const {
+		return m_precomputed ? m_acyclic : lemon::dag(*this);
+	}
+
+	/**
+	 * @return nodes without in-arcs in the order of their ids
+	 */
+	std::vector<lemon::ListDigraph::Node> getSources() const {
+		return m_precomputed ? m_sources : computeSources();
+	}
+
+	/**
+	 * @param section section id
+	 * @return the unit node of \p section (the one with the smallest id if
+	 * there are several), or lemon::INVALID if there is none
+	 */
+	lemon::ListDigraph::Node getUnit(int section) const {
+		if (!m_precomputed) {
+			lemon::ListDigraph::Node unit = lemon::INVALID;
+			for (auto v : nodes()) {
+				if (isUnit(v) && getSection(v) == section &&
+						(unit == lemon::INVALID || id(v) < id(unit))) {
+					unit = v;
+				}
+			}
+			return unit;
+		}
+
+		ArrayView<int> units = m_sectionIndex->units(section);
+		return units.empty() ? lemon::INVALID :
+			nodeFromId(m_sectionIndex->node(units[0]));
+	}
+
+	/**
+	 * @param a out-arc of a test node
+	 * @return whether \p a is one of the out-arcs with the highest grade of
+	 * its test node
+	 * @throws std::invalid_argument if a grade of the test node is no number
+	 */
+	bool isMaxGradeBranch(const lemon::ListDigraph::Arc &a) const {
+		int v = id(source(a));
+		std::shared_ptr<const StaticGraph> graph = getStaticGraph();
+		std::shared_ptr<const GradeTable> grades = getGradeTable();
+		if (!grades->hasGrades(v)) {
+			throw std::invalid_argument("Test node with test id " +
+				std::to_string(getTestId(source(a))) +
+				" has a grade that is no number.");
+		}
+
+		ArrayView<GradedArc> arcs = grades->gradedArcs(v);
+		for (std::size_t i = grades->maxGradeBegin(v); i < arcs.size(); i++) {
+			if (graph->arc(arcs[i].arc) == id(a)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// @}
+
+	// Structure Modifiers
+	// These hide the ones of lemon::ListDigraph in order to discard the
+	// precomputed members, see #precompute().
+	// @{
+
+	/**
+	 * Adds a new node.
+	 *
+	 * @return the new node
+	 */
+	lemon::ListDigraph::Node addNode() {
+		discardPrecomputed();
+		return lemon::ListDigraph::addNode();
+	}
+
+	/**
+	 * Adds a new arc.
+	 *
+	 * @param s the source of the new arc
+	 * @param t the target of the new arc
+	 * @return the new arc
+	 */
+	lemon::ListDigraph::Arc addArc(lemon::ListDigraph::Node s,
+			lemon::ListDigraph::Node t) {
+		discardPrecomputed();
+		return lemon::ListDigraph::addArc(s, t);
+	}
+
+	/**
+	 * Erases a node and its incident arcs.
+	 *
+	 * @param v the node
+	 */
+	void erase(lemon::ListDigraph::Node v) {
+		discardPrecomputed();
+		lemon::ListDigraph::erase(v);
+	}
+
+	/**
+	 * Erases an arc.
+	 *
+	 * @param a the arc
+	 */
+	void erase(lemon::ListDigraph::Arc a) {
+		discardPrecomputed();
+		lemon::ListDigraph::erase(a);
+	}
+
+	/**
+	 * Changes the target of an arc.
+	 *
+	 * @param a the arc
+	 * @param v the new target of \p a
+	 */
+	void changeTarget(lemon::ListDigraph::Arc a, lemon::ListDigraph::Node v) {
+		discardPrecomputed();
+		lemon::ListDigraph::changeTarget(a, v);
+	}
+
+	/**
+	 * Changes the source of an arc.
+	 *
+	 * @param a the arc
+	 * @param v the new source of \p a
+	 */
+	void changeSource(lemon::ListDigraph::Arc a, lemon::ListDigraph::Node v) {
+		discardPrecomputed();
+		lemon::ListDigraph::changeSource(a, v);
+	}
+
+	/**
+	 * Contracts node \p b into node \p a, moving the arcs of \p b to \p a.
+	 *
+	 * @param a the node that is kept
+	 * @param b the node that is contracted into \p a
+	 * @param r whether loops created by the contraction are removed
+	 */
+	void contract(lemon::ListDigraph::Node a, lemon::ListDigraph::Node b,
+			bool r = true) {
+		discardPrecomputed();
+		lemon::ListDigraph::contract(a, b, r);
+	}
+
+	// @}
+
 	// Type Checkers, Getter and Setter
 	// @{
 
@@ -181,7 +999,7 @@ public:
 	 * @return whether \p v is a unit node
 	 */
 	bool isUnit(const lemon::ListDigraph::Node &v) const {
-		return m_type[v] < NodeType::split;
+		return getClass(v) & NodeClass::unit;
 	}
 
 	/**
@@ -189,7 +1007,7 @@ public:
 	 * @return whether \p v is a split node
 	 */
 	bool isSplit(const lemon::ListDigraph::Node &v) const {
-		return m_type[v] == NodeType::split;
+		return getClass(v) & NodeClass::split;
 	}
 
 	/**
@@ -197,7 +1015,7 @@ public:
 	 * @return whether \p v is a condition node
 	 */
 	bool isCondition(const lemon::ListDigraph::Node &v) const {
-		return m_type[v] == NodeType::condition;
+		return getClass(v) & NodeClass::condition;
 	}
 
 	/**
@@ -205,7 +1023,7 @@ public:
 	 * @return whether \p v is a test node
 	 */
 	bool isTest(const lemon::ListDigraph::Node &v) const {
-		return m_type[v] >= NodeType::test && m_type[v] < NodeType::join;
+		return getClass(v) & NodeClass::test;
 	}
 
 	/**
@@ -214,7 +1032,7 @@ public:
 	 * possibly multiple outgoing edges
 	 */
 	bool isSplitLike(const lemon::ListDigraph::Node &v) const {
-		return m_type[v] >= NodeType::split && m_type[v] < NodeType::join;
+		return getClass(v) & NodeClass::splitLike;
 	}
 
 	/**
@@ -222,7 +1040,7 @@ public:
 	 * @return whether \p v is a join node
 	 */
 	bool isJoin(const lemon::ListDigraph::Node &v) const {
-		return m_type[v] >= NodeType::join;
+		return getClass(v) & NodeClass::join;
 	}
 
 	/**
@@ -230,9 +1048,15 @@ public:
 	 * @return whether the type of \p v is unknown
 	 */
 	bool isUnknown(const lemon::ListDigraph::Node &v) const {
-		return m_type[v] < NodeType::inactive
-		   || (m_type[v] > NodeType::completed && m_type[v] < NodeType::split)
-		   || (m_type[v] > NodeType::test && m_type[v] < NodeType::join);
+		return getClass(v) & NodeClass::unknown;
+	}
+
+	/**
+	 * @param v the node
+	 * @return the classes of the type of \p v, see NodeClass
+	 */
+	uint8_t getClass(const lemon::ListDigraph::Node &v) const {
+		return NodeClass::of(m_node[v].type);
 	}
 
 	/**
@@ -240,7 +1064,7 @@ public:
 	 * @return the type of \p v
 	 */
 	int getType(const lemon::ListDigraph::Node &v) const {
-		return m_type[v];
+		return m_node[v].type;
 	}
 
 	/**
@@ -251,7 +1075,8 @@ public:
 	 * implicitly casted to int)
 	 */
 	void setType(const lemon::ListDigraph::Node &v, int type) {
-		m_type[v] = type;
+		discardPrecomputed();
+		m_node[v].type = type;
 	}
 
 	// @}
@@ -263,7 +1088,7 @@ public:
 	 * @return the section id of \p v if \p v is a unit node, -1 otherwise
 	 */
 	int getSection(const lemon::ListDigraph::Node &v) const {
-		return isUnit(v) ? m_ref[v] : -1;
+		return isUnit(v) ? m_node[v].ref : -1;
 	}
 
 	/**
@@ -287,7 +1112,7 @@ public:
 	 * for \p v to be reachable if \p v is a join node, -1 otherwise
 	 */
 	int getNecessaryInArcs(const lemon::ListDigraph::Node &v) const {
-		return isJoin(v) ? m_ref[v] : -1;
+		return isJoin(v) ? m_node[v].ref : -1;
 	}
 
 	/**
@@ -311,7 +1136,7 @@ public:
 	 * otherwise
 	 */
 	int getConditionId(const lemon::ListDigraph::Node &v) const {
-		return isCondition(v) ? m_ref[v] : -1;
+		return isCondition(v) ? m_node[v].ref : -1;
 	}
 
 	/**
@@ -334,7 +1159,7 @@ public:
 	 * @return the test id of \p v if \p v is a test node, -1 otherwise
 	 */
 	int getTestId(const lemon::ListDigraph::Node &v) const {
-		return isTest(v) ? m_ref[v] : -1;
+		return isTest(v) ? m_node[v].ref : -1;
 	}
 
 	/**
@@ -411,7 +1236,16 @@ public:
 	 * @param a the edge
 	 * @return the condition value or test grade associated with \p a
 	 */
-	std::string getConditionBranch(const lemon::ListDigraph::Arc &a) const {
+	const std::string &getConditionBranch(const lemon::ListDigraph::Arc &a) const {
+		return m_branchNames[m_condition[a]];
+	}
+
+	/**
+	 * @param a the edge
+	 * @return the branch id of the condition value or test grade associated
+	 * with \p a
+	 */
+	int getConditionBranchId(const lemon::ListDigraph::Arc &a) const {
 		return m_condition[a];
 	}
 
@@ -423,64 +1257,120 @@ public:
 	 */
 	void setConditionBranch(const lemon::ListDigraph::Arc &a,
 			const std::string &branch) {
-		m_condition[a] = branch;
+		discardPrecomputed();
+		m_condition[a] = internBranch(branch);
 	}
 
-	// @}
-	// Helper Functions for Join nodes
-	// @{
-
 	/**
-	 * Resets the activated in-arcs of a join node to 0.
-	 *
-	 * @param v the join node
-	 * @throws exception if \p v is not a join node
+	 * @param branch a condition value or test grade
+	 * @return the branch id of \p branch, or -1 if no edge of this net ever
+	 * had \p branch as its condition value or test grade
 	 */
-	void resetActivatedInArcs(const lemon::ListDigraph::Node &v) {
-		if (isJoin(v)) {
-			m_type[v] = NodeType::join;
-		} else {
-			throw "resetActivatedInArcs() on node which is not a join.";
-		}
+	int getBranchId(const std::string &branch) const {
+		auto found = m_branchIds.find(branch);
+		return found == m_branchIds.end() ? -1 : found->second;
 	}
 
 	/**
-	 * Increments the activated in-arcs of a join node by 1.
-	 *
-	 * @param v the join node
-	 * @throws exception if \p v is not a join node
+	 * @param branchId a branch id of this net
+	 * @return the condition value or test grade with id \p branchId
 	 */
-	void incrementActivatedInArcs(const lemon::ListDigraph::Node &v) {
-		if (isJoin(v)) {
-			m_type[v]++;
-		} else {
-			throw "incrementActivatedInArcs() on node which is not a join.";
-		}
+	const std::string &getBranchName(int branchId) const {
+		return m_branchNames[branchId];
 	}
 
+	// @}
+
 	/**
-	 * @param v the join node
-	 * @throws exception if \p v is not a join node
-	 * @return activated in-arcs of \p v
+	 * Writes this LearningNet as a compiled net to the stream \p out, see
+	 * CompiledNet. Nodes and arcs are numbered in the order of their ids.
+	 *
+	 * @param out the stream to which the compiled net is written
 	 */
-	int getActivatedInArcs(const lemon::ListDigraph::Node &v) const {
-		if (isJoin(v)) {
-			return m_type[v] - NodeType::join;
-		} else {
-			throw "getActivatedInArcs() on node which is not a join.";
+	void compile(std::ostream &out) const {
+		// Index of each node and arc in the order of ids.
+		std::vector<lemon::ListDigraph::Node> nodeList = sortedNodes();
+		std::vector<uint32_t> nodeIndex(maxNodeId() + 1);
+		for (std::size_t i = 0; i < nodeList.size(); i++) {
+			nodeIndex[id(nodeList[i])] = i;
 		}
-	}
 
-	/**
-	 * @param v the node
-	 * @return whether \p v is join node with at least as many activated in-arcs
-	 * as necessary ones
-	 */
-	bool isCompletedJoin(const lemon::ListDigraph::Node &v) const {
-		return isJoin(v) && getActivatedInArcs(v) >= getNecessaryInArcs(v);
-	}
+		std::vector<lemon::ListDigraph::Arc> arcList;
+		for (auto a : arcs()) {
+			arcList.push_back(a);
+		}
+		std::sort(arcList.begin(), arcList.end(),
+			[](lemon::ListDigraph::Arc a, lemon::ListDigraph::Arc b) {
+				return id(a) < id(b);
+			});
+
+		std::vector<CompiledNode> compiledNodes;
+		for (auto v : nodeList) {
+			compiledNodes.push_back(CompiledNode{m_node[v].type, m_node[v].ref});
+		}
 
-	// @}
+		// Arcs with the branch ids of this net.
+		std::vector<CompiledArc> compiledArcs;
+		for (auto a : arcList) {
+			compiledArcs.push_back(CompiledArc{nodeIndex[id(source(a))],
+				nodeIndex[id(target(a))], static_cast<uint32_t>(m_condition[a])});
+		}
+		std::vector<uint32_t> branchOffsets{0};
+		std::string branchChars;
+		for (auto &branch : m_branchNames) {
+			branchChars += branch;
+			branchOffsets.push_back(branchChars.size());
+		}
+
+		// Out-arcs in CSR form. Loading adds the arcs in the order of their
+		// indices and OutArcIt visits the out-arcs of a node from the last
+		// added one, so they are listed in descending order of indices.
+		std::vector<uint32_t> outArcOffsets(nodeList.size() + 1, 0);
+		for (auto &arc : compiledArcs) {
+			outArcOffsets[arc.source + 1]++;
+		}
+		for (std::size_t i = 0; i < nodeList.size(); i++) {
+			outArcOffsets[i + 1] += outArcOffsets[i];
+		}
+		std::vector<uint32_t> outArcIds(compiledArcs.size());
+		std::vector<uint32_t> next(outArcOffsets.begin(), outArcOffsets.end() - 1);
+		for (std::size_t a = compiledArcs.size(); a-- > 0; ) {
+			outArcIds[next[compiledArcs[a].source]++] = a;
+		}
+
+		std::vector<int32_t> target{m_target == lemon::INVALID ? -1 :
+			static_cast<int32_t>(nodeIndex[id(m_target)])};
+
+		// Precomputed structure, computed anew in case the net was changed.
+		std::vector<CompiledSectionEntry> sectionIndex;
+		for (auto &entry : computeSectionIndex()) {
+			sectionIndex.push_back(CompiledSectionEntry{
+				entry.first, nodeIndex[id(entry.second)]});
+		}
+		std::vector<uint32_t> topologicalOrder;
+		for (auto v : computeTopologicalOrder()) {
+			topologicalOrder.push_back(nodeIndex[id(v)]);
+		}
+		std::vector<uint32_t> sources;
+		for (auto v : computeSources()) {
+			sources.push_back(nodeIndex[id(v)]);
+		}
+
+		std::vector<std::pair<uint32_t, std::string>> sections{
+			{CompiledSection::nodes, CompiledNet::toBytes(compiledNodes)},
+			{CompiledSection::arcs, CompiledNet::toBytes(compiledArcs)},
+			{CompiledSection::outArcOffsets, CompiledNet::toBytes(outArcOffsets)},
+			{CompiledSection::outArcIds, CompiledNet::toBytes(outArcIds)},
+			{CompiledSection::branchOffsets, CompiledNet::toBytes(branchOffsets)},
+			{CompiledSection::branchChars, branchChars},
+			{CompiledSection::target, CompiledNet::toBytes(target)},
+			{CompiledSection::sectionIndex, CompiledNet::toBytes(sectionIndex)},
+			{CompiledSection::topologicalOrder, CompiledNet::toBytes(topologicalOrder)},
+			{CompiledSection::sources, CompiledNet::toBytes(sources)}
+		};
+
+		CompiledNet::write(out, sections);
+	}
 
 	/**
 	 * Writes this LearningNet in LGF to the stream \p out.
@@ -491,11 +1381,32 @@ public:
 	 */
 	void write(std::ostream &out = std::cout,
 			const lemon::ListDigraph::ArcMap<bool> *visited = nullptr) const {
+		write(out, NodeFieldMap<&NodeRecord::type>{m_node}, visited, m_recommended);
+	}
+
+	/**
+	 * Writes this LearningNet in LGF to the stream \p out, using the given
+	 * node types and recommendation instead of the ones of this LearningNet.
+	 *
+	 * @tparam TypeMap lemon map from nodes to types
+	 * @tparam VisitedMap lemon map from arcs to bool
+	 * @param out the stream to which the learning net is written
+	 * @param types type of each node
+	 * @param visited optional, mapping from edges to whether that edge was
+	 * visited during a learning path search, also written to \p out if given
+	 * @param recommended recommended learning path (or node)
+	 */
+	template<typename TypeMap, typename VisitedMap>
+	void write(std::ostream &out,
+			const TypeMap &types,
+			const VisitedMap *visited,
+			const std::vector<lemon::ListDigraph::Node> &recommended) const {
 		// Write lemon graph file to cout.
+		BranchNameMap branches{*this};
 		lemon::DigraphWriter<lemon::ListDigraph> writer{*this, out};
-		writer.nodeMap("type", m_type)
-		      .nodeMap("ref", m_ref)
-		      .arcMap("condition", m_condition);
+		writer.nodeMap("type", types)
+		      .nodeMap("ref", NodeFieldMap<&NodeRecord::ref>{m_node})
+		      .arcMap("condition", branches);
 
 		// Write out visited arcs if given.
 		if (visited) {
@@ -503,41 +1414,10 @@ public:
 		}
 
 		writer.node("target", m_target)
-		      .attribute("recommended", stringify(m_recommended))
+		      .attribute("recommended", stringify(recommended))
 		      .run();
 	}
 
-	/**
-	 * Set the type of the unit nodes given by \p completed to completed.
-	 * @param completed section numbers of completed unit nodes
-	 * @return section numbers of completed units for which no unit node could
-	 * be found
-	 */
-	std::vector<int> setCompleted(const std::vector<int> &completed)
-	{
-		// Get map: sectionId -> node.
-		std::map<int, lemon::ListDigraph::Node> sectionNode;
-		for (auto v : nodes()) {
-			if (isUnit(v)) {
-				sectionNode[getSection(v)] = v;
-			}
-		}
-
-		// Set type of completed units.
-		std::vector<int> couldNotBeSet;
-		for (int completedSection : completed) {
-			auto completedNode = sectionNode.find(completedSection);
-			if (completedNode != sectionNode.end()) {
-				// Only set it for units, not for connectives!
-				setType(completedNode->second, NodeType::completed);
-			} else {
-				couldNotBeSet.push_back(completedSection);
-			}
-		}
-
-		return couldNotBeSet;
-	}
-
 };
 
 }
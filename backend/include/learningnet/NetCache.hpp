@@ -0,0 +1,164 @@
+#pragma once
+
+#include <learningnet/LearningNet.hpp>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace learningnet {
+
+/**
+ * Content-addressed cache of parsed learning nets for long-running processes.
+ *
+ * Nets are looked up by a hash of their LGF text, such that a repeated
+ * request with the same network skips reading the LGF. The text itself is
+ * stored as well and compared on a hit, so a hash collision only results in a
+ * miss. If more than #capacity() nets are cached, the least recently used net
+ * is evicted.
+ *
+ * Cached nets are shared and must not be changed. Nets handed out by #get()
+ * stay valid after their eviction for as long as they are used.
+ */
+class NetCache
+{
+private:
+	//! A cached net together with the text it was read from.
+	struct Entry {
+		std::size_t hash; //!< hash of #network
+		std::string network; //!< LGF text of the net
+		std::shared_ptr<const LearningNet> net; //!< the parsed net
+	};
+
+	std::size_t m_capacity; //!< maximum number of cached nets
+
+	//! cached nets, the most recently used one first
+	std::list<Entry> m_entries;
+
+	//! mapping from the hash of a net's text to its entry in #m_entries
+	std::unordered_map<std::size_t, std::list<Entry>::iterator> m_index;
+
+	unsigned long m_hits; //!< number of lookups answered from the cache
+
+	unsigned long m_misses; //!< number of lookups that had to read the net
+
+	mutable std::mutex m_mutex; //!< guards all other members
+
+	/**
+	 * Inserts \p entry as the most recently used net, replacing an entry with
+	 * the same hash and evicting the least recently used nets if necessary.
+	 * Assumes that #m_mutex is locked.
+	 *
+	 * @param entry the entry to insert
+	 */
+	void insert(Entry &&entry) {
+		auto found = m_index.find(entry.hash);
+		if (found != m_index.end()) {
+			m_entries.erase(found->second);
+			m_index.erase(found);
+		}
+
+		m_entries.push_front(std::move(entry));
+		m_index[m_entries.front().hash] = m_entries.begin();
+
+		while (m_entries.size() > m_capacity) {
+			m_index.erase(m_entries.back().hash);
+			m_entries.pop_back();
+		}
+	}
+
+public:
+	/**
+	 * Creates an empty NetCache.
+	 *
+	 * @param capacity maximum number of cached nets, 0 disables caching
+	 */
+	explicit NetCache(std::size_t capacity)
+		: m_capacity{capacity}
+		, m_entries{}
+		, m_index{}
+		, m_hits{0}
+		, m_misses{0}
+	{}
+
+	NetCache(const NetCache&) = delete;
+	NetCache &operator=(const NetCache&) = delete;
+
+	/**
+	 * Returns the net read from \p network, reading it only if it is not
+	 * cached yet.
+	 *
+	 * @param network LGF text of the learning net
+	 * @param length number of characters in \p network
+	 * @return the shared learning net
+	 * @throws exception if the net has to be read and is not valid LGF
+	 */
+	std::shared_ptr<const LearningNet> get(const char *network,
+			std::size_t length) {
+		std::string_view text{network, length};
+		std::size_t hash = std::hash<std::string_view>{}(text);
+
+		{
+			std::lock_guard<std::mutex> lock{m_mutex};
+			auto found = m_index.find(hash);
+			if (found != m_index.end() && found->second->network == text) {
+				m_hits++;
+				m_entries.splice(m_entries.begin(), m_entries, found->second);
+				return found->second->net;
+			}
+			m_misses++;
+		}
+
+		// Read the net without holding the lock, other nets may be looked up
+		// in the meantime.
+		std::shared_ptr<const LearningNet> net =
+			std::make_shared<const LearningNet>(network, length);
+
+		if (m_capacity > 0) {
+			std::lock_guard<std::mutex> lock{m_mutex};
+			insert(Entry{hash, std::string{text}, net});
+		}
+		return net;
+	}
+
+	// Statistics
+	// @{
+
+	/**
+	 * @return number of lookups answered from the cache
+	 */
+	unsigned long getHits() const {
+		std::lock_guard<std::mutex> lock{m_mutex};
+		return m_hits;
+	}
+
+	/**
+	 * @return number of lookups that had to read the net
+	 */
+	unsigned long getMisses() const {
+		std::lock_guard<std::mutex> lock{m_mutex};
+		return m_misses;
+	}
+
+	/**
+	 * @return number of currently cached nets
+	 */
+	std::size_t size() const {
+		std::lock_guard<std::mutex> lock{m_mutex};
+		return m_entries.size();
+	}
+
+	/**
+	 * @return maximum number of cached nets
+	 */
+	std::size_t capacity() const {
+		return m_capacity;
+	}
+
+	// @}
+};
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <learningnet/LearningNet.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace learningnet {
+
+/**
+ * Registry of the current learning net of each course for long-running
+ * processes, following the read-copy-update pattern.
+ *
+ * Readers take a snapshot of the whole registry with one atomic load and never
+ * wait for writers. Writers copy the registry, change the copy and publish it
+ * with one atomic store. Old snapshots and the nets only they refer to are
+ * freed once the last reader drops them, so requests that are in progress
+ * while a net is replaced keep working on the old version.
+ */
+class NetRegistry
+{
+public:
+	//! A published net together with its version.
+	struct Entry {
+		std::shared_ptr<const LearningNet> net; //!< the published net
+		unsigned long version; //!< increases with every publication
+	};
+
+	//! Immutable mapping from net ids to their current entries.
+	using Snapshot = std::unordered_map<std::string, Entry>;
+
+private:
+	//! the current snapshot, only accessed via std::atomic_load/atomic_store
+	std::shared_ptr<const Snapshot> m_snapshot;
+
+	std::mutex m_writeMutex; //!< serializes writers
+
+	unsigned long m_version; //!< version of the last publication
+
+public:
+	/**
+	 * Creates an empty NetRegistry.
+	 */
+	NetRegistry()
+		: m_snapshot{std::make_shared<const Snapshot>()}
+		, m_writeMutex{}
+		, m_version{0}
+	{}
+
+	NetRegistry(const NetRegistry&) = delete;
+	NetRegistry &operator=(const NetRegistry&) = delete;
+
+	/**
+	 * @return the current snapshot, stays unchanged by later publications
+	 */
+	std::shared_ptr<const Snapshot> snapshot() const {
+		return std::atomic_load(&m_snapshot);
+	}
+
+	/**
+	 * @param id id of the net
+	 * @return the current net published under \p id, or nullptr
+	 */
+	std::shared_ptr<const LearningNet> get(const std::string &id) const {
+		std::shared_ptr<const Snapshot> current = snapshot();
+		auto found = current->find(id);
+		return found == current->end() ? nullptr : found->second.net;
+	}
+
+	/**
+	 * Publishes \p net under \p id, replacing the net published before.
+	 * Readers see either the old or the new net, never a partial update.
+	 *
+	 * @param id id of the net
+	 * @param net the new net, must not be changed afterwards
+	 * @return version of the publication
+	 */
+	unsigned long publish(const std::string &id,
+			std::shared_ptr<const LearningNet> net) {
+		std::lock_guard<std::mutex> lock{m_writeMutex};
+		auto next = std::make_shared<Snapshot>(*std::atomic_load(&m_snapshot));
+		(*next)[id] = Entry{std::move(net), ++m_version};
+		std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>{next});
+		return m_version;
+	}
+
+	/**
+	 * Removes the net published under \p id.
+	 *
+	 * @param id id of the net
+	 * @return whether a net was published under \p id
+	 */
+	bool remove(const std::string &id) {
+		std::lock_guard<std::mutex> lock{m_writeMutex};
+		std::shared_ptr<const Snapshot> current = std::atomic_load(&m_snapshot);
+		if (current->find(id) == current->end()) {
+			return false;
+		}
+
+		auto next = std::make_shared<Snapshot>(*current);
+		next->erase(id);
+		std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>{next});
+		return true;
+	}
+};
+
+}
@@ -1,9 +1,15 @@
 #pragma once
 
 #include <learningnet/Compressor.hpp>
+#include <learningnet/JoinCounters.hpp>
 #include <learningnet/Module.hpp>
-#include <lemon/connectivity.h> // for dag
+#include <learningnet/SlicedCounters.hpp>
+#include <learningnet/ThreadPool.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <deque>
+#include <iterator>
+#include <mutex>
 
 namespace learningnet {
 
@@ -18,182 +24,687 @@ class NetworkChecker : public Module
 {
 private:
 
+	/**
+	 * State of a learning path search that can be branched at condition nodes.
+	 * Searches running in parallel each have their own state.
+	 */
+	struct Search {
+		//! Activated in-arcs of join nodes.
+		JoinCounters activatedInArcs;
+
+		//! Ids of the join nodes whose counters in #activatedInArcs were
+		//! incremented, in this order.
+		std::vector<int> incremented;
+
+		//! Index of the chosen branch of each indexed condition id, -1 if none
+		//! was chosen yet.
+		std::vector<int> chosen;
+
+		//! Ids of the activated nodes that were not visited yet.
+		std::deque<int> pending;
+	};
+
+	//! Number of searches into which the search of each worker of #m_pool is
+	//! split, such that workers whose searches end early can take others.
+	static constexpr std::size_t SEARCHES_PER_WORKER = 4;
+
+	//! Set of lanes of the bit-sliced search, one bit per combination of
+	//! condition values.
+	using Lanes = SlicedCounters::Lanes;
+
+	//! Number of combinations checked by one pass of the bit-sliced search.
+	static constexpr int LANE_COUNT = SlicedCounters::LANE_COUNT;
+
 	//! Whether the graph is compressed before searching learning paths.
 	bool m_useCompression;
 
+	//! Pool running parallel learning path searches if given, else nullptr.
+	ThreadPool *m_pool;
+
+	//! Largest number of combinations of condition values that are checked
+	//! by the bit-sliced search instead of a branched search.
+	uint64_t m_maxSlicedCombinations;
+
+	//! Ids of the nodes without in-arcs, where learning path searches start.
+	std::vector<int> m_sources;
+
+	//! Ids of the nodes in topological order.
+	std::vector<int> m_topologicalOrder;
+
+	//! Index of the condition id of each condition node by node id, -1 for
+	//! other nodes. Condition ids are indexed in ascending order.
+	std::vector<int> m_conditionIndex;
+
+	//! Branch ids of the condition values of each indexed condition id.
+	std::vector<std::vector<int>> m_conditionBranches;
+
+	//! Index of the selector of each branch of each indexed condition id in
+	//! the bit-sliced search.
+	std::vector<std::vector<int>> m_branchSelector;
+
+	//! Index of the selector of each out-arc of a condition node in the
+	//! bit-sliced search, -1 for other out-arcs.
+	std::vector<int> m_arcSelector;
+
+	//! Indices of the branches of the first combination of condition values
+	//! found without a learning path, empty if none was found.
+	std::vector<int> m_failing;
+
+	//! Guards #m_failing while searches run in parallel.
+	std::mutex m_failingMutex;
+
+	/**
+	 * Pushes the target of an out-arc to the pending nodes of a search if the
+	 * arc activates it, i.e. unless the target is a join whose necessary
+	 * in-arcs are not all activated yet.
+	 *
+	 * @param graph arrays of the nodes and arcs of the net, with branch ids
+	 * @param i index of the out-arc in \p graph
+	 * @param search the search
+	 */
+	void exploreArc(const StaticGraph &graph, int i, Search &search)
+	{
+		int target = graph.target(i);
+
+		// The ref value of a join is its number of necessary in-arcs.
+		if (graph.hasClass(target, NodeClass::join)) {
+			search.incremented.push_back(target);
+			if (search.activatedInArcs.increment(target) != graph.ref(target)) {
+				return;
+			}
+		}
+
+		// Push conditions to front, they'll be used after other nodes such
+		// that the search branches as late as possible.
+		if (graph.hasClass(target, NodeClass::condition)) {
+			search.pending.push_front(target);
+		} else {
+			search.pending.push_back(target);
+		}
+	}
+
+	/**
+	 * Explores the out-arcs of a condition node that belong to a branch, or its
+	 * else-branch if it has no out-arc of this branch.
+	 *
+	 * @param graph arrays of the nodes and arcs of the net, with branch ids
+	 * @param v node id of the condition node
+	 * @param branch branch id of the condition value
+	 * @param elseBranchId branch id of else-branches
+	 * @param search the search
+	 */
+	void exploreBranch(const StaticGraph &graph,
+			int v,
+			int branch,
+			int elseBranchId,
+			Search &search)
+	{
+		bool explored = false;
+		int elseBranch = -1;
+		for (int i = graph.outBegin(v); i < graph.outEnd(v); i++) {
+			if (graph.branch(i) == branch) {
+				explored = true;
+				exploreArc(graph, i, search);
+			} else if (graph.branch(i) == elseBranchId) {
+				elseBranch = i;
+			}
+		}
+
+		// If no other branch was visited, the else-branch is explored.
+		if (!explored && elseBranch >= 0) {
+			exploreArc(graph, elseBranch, search);
+		}
+	}
+
 	/**
-	 * @tparam ArcItType InArcIt or OutArcIt
-	 * @param net the learning net containing \p v
-	 * @param v the node
-	 * @return whether \p v has at most one incoming or outgoing edge (depending
-	 * on ArcItType)
+	 * Continues a search at its pending nodes until the target is reached, no
+	 * node is pending anymore, or a condition node is visited whose condition
+	 * id has no chosen branch yet.
+	 *
+	 * @param net the learning net
+	 * @param graph arrays of the nodes and arcs of \p net, with branch ids
+	 * @param search the search
+	 * @param targetReachable is assigned whether the target was reached
+	 * @return node id of the condition node at which the search stopped, -1 if
+	 * it stopped for another reason
 	 */
-	template<typename ArcItType>
-	bool hasAtMostOneArc(const LearningNet &net,
-			const lemon::ListDigraph::Node &v)
+	int searchUntilUnchosen(const LearningNet &net,
+			const StaticGraph &graph,
+			Search &search,
+			bool &targetReachable)
 	{
-		int count = 0;
-		for (ArcItType a(net, v); a != lemon::INVALID; ++a) {
-			if (++count > 1) {
-				return false;
+		targetReachable = false;
+		int elseBranchId = net.getBranchId(CONDITION_ELSE_BRANCH_KEYWORD);
+		int maxGradeId = net.getBranchId(MAX_GRADE);
+		int targetId = net.id(net.getTarget());
+
+		while (!search.pending.empty()) {
+			int node = search.pending.back();
+			search.pending.pop_back();
+
+			if (node == targetId) {
+				targetReachable = true;
+				return -1;
+			} else if (graph.hasClass(node, NodeClass::condition)) {
+				// Condition: only visit the chosen branch, stop if there is none.
+				int condition = m_conditionIndex[node];
+				if (search.chosen[condition] < 0) {
+					return node;
+				}
+				exploreBranch(graph, node,
+					m_conditionBranches[condition][search.chosen[condition]],
+					elseBranchId, search);
+			} else if (graph.hasClass(node, NodeClass::test)) {
+				// For a test one of the branches with the highest grade should
+				// lead to the target.
+				for (int i = graph.outBegin(node); i < graph.outEnd(node); i++) {
+					if (graph.branch(i) == maxGradeId) {
+						exploreArc(graph, i, search);
+					}
+				}
+			} else {
+				// Non-Condition/non-test: Push all successors
+				// (unless it is a locked join).
+				for (int i = graph.outBegin(node); i < graph.outEnd(node); i++) {
+					exploreArc(graph, i, search);
+				}
 			}
 		}
-		return true;
+
+		return -1;
+	}
+
+	/**
+	 * Starts a search at the sources of the net, with no activated in-arcs of
+	 * any join and no chosen branches.
+	 *
+	 * @param net the learning net
+	 * @return the search
+	 */
+	Search startSearch(const LearningNet &net)
+	{
+		return Search{
+			JoinCounters(net.maxNodeId() + 1),
+			std::vector<int>(),
+			std::vector<int>(m_conditionBranches.size(), -1),
+			std::deque<int>(m_sources.begin(), m_sources.end())
+		};
+	}
+
+	/**
+	 * @param chosen indices of chosen branches, -1 for condition ids without
+	 * a chosen branch
+	 * @return the first combination of condition values that agrees with
+	 * \p chosen, given by the indices of its branches
+	 */
+	static std::vector<int> firstCombination(const std::vector<int> &chosen)
+	{
+		std::vector<int> combination(chosen.size());
+		for (std::size_t i = 0; i < chosen.size(); i++) {
+			combination[i] = std::max(chosen[i], 0);
+		}
+		return combination;
+	}
+
+	/**
+	 * @param x indices of the branches of a combination of condition values
+	 * @param y indices of the branches of a combination of condition values
+	 * @return whether \p x precedes \p y in the order in which
+	 * pathsForAllConditions() reports combinations, i.e. compared from the
+	 * last condition id to the first
+	 */
+	static bool precedes(const std::vector<int> &x, const std::vector<int> &y)
+	{
+		return std::lexicographical_compare(x.rbegin(), x.rend(),
+			y.rbegin(), y.rend());
+	}
+
+	/**
+	 * @param chosen indices of chosen branches, -1 for condition ids without
+	 * a chosen branch
+	 * @return whether the first combination that agrees with \p chosen
+	 * precedes #m_failing
+	 */
+	bool precedesFailing(const std::vector<int> &chosen)
+	{
+		std::vector<int> combination = firstCombination(chosen);
+		std::lock_guard<std::mutex> lock{m_failingMutex};
+		return m_failing.empty() || precedes(combination, m_failing);
+	}
+
+	/**
+	 * Stores the first combination that agrees with \p chosen in #m_failing
+	 * if it precedes the combination stored before.
+	 *
+	 * @param chosen indices of chosen branches of a search that did not reach
+	 * the target, -1 for condition ids whose condition nodes were not visited
+	 */
+	void storeFailing(const std::vector<int> &chosen)
+	{
+		std::vector<int> combination = firstCombination(chosen);
+		std::lock_guard<std::mutex> lock{m_failingMutex};
+		if (m_failing.empty() || precedes(combination, m_failing)) {
+			m_failing = std::move(combination);
+		}
 	}
 
 	/**
-	 * Executes a learning path search in \p net for a given value for each
-	 * condition id.
+	 * Continues a search at its pending nodes and branches it at every
+	 * condition node whose condition id has no chosen branch yet, once for
+	 * each branch of the condition id. Each branch continues with a copy of
+	 * the pending nodes while the counters of the joins are shared and
+	 * restored after the branch.
+	 *
+	 * If the target is not reached in a branch, the first combination of
+	 * condition values that agrees with the chosen branches is stored in
+	 * #m_failing. Branches that cannot lead to an earlier combination than the
+	 * one stored, possibly by another search, are skipped.
 	 *
 	 * @param net the learning net
-	 * @param branchCombination mapping from condition ids to condition values
-	 * @return whether there exists a learning path in \p net for the condition
-	 * values given by \p branchCombination
+	 * @param graph arrays of the nodes and arcs of \p net, with branch ids
+	 * @param search the search
 	 */
-	bool targetReachableByTopSort(LearningNet &net,
-			const std::map<int, std::string> &branchCombination)
+	void searchAllBranches(const LearningNet &net,
+			const StaticGraph &graph,
+			Search &search)
 	{
 		bool targetReachable = false;
+		int node = searchUntilUnchosen(net, graph, search, targetReachable);
+		if (node < 0) {
+			if (!targetReachable) {
+				storeFailing(search.chosen);
+			}
+			return;
+		}
 
-		// Collect sources: nodes with indegree 0.
-		std::deque<lemon::ListDigraph::Node> sources;
-		for (auto v : net.nodes()) {
-			if (net.isJoin(v)) {
-				net.resetActivatedInArcs(v);
+		int elseBranchId = net.getBranchId(CONDITION_ELSE_BRANCH_KEYWORD);
+		int condition = m_conditionIndex[node];
+		std::deque<int> pending = search.pending;
+		std::size_t incremented = search.incremented.size();
+		for (std::size_t i = 0; i < m_conditionBranches[condition].size(); i++) {
+			// Later branches only lead to later combinations.
+			search.chosen[condition] = i;
+			if (!precedesFailing(search.chosen)) {
+				break;
+			}
+
+			search.pending = pending;
+			exploreBranch(graph, node, m_conditionBranches[condition][i],
+				elseBranchId, search);
+			searchAllBranches(net, graph, search);
+
+			// Undo the activations of in-arcs in this branch.
+			while (search.incremented.size() > incremented) {
+				search.activatedInArcs.decrement(search.incremented.back());
+				search.incremented.pop_back();
+			}
+		}
+		search.chosen[condition] = -1;
+	}
+
+	/**
+	 * Splits a search into independent searches by branching it at condition
+	 * nodes, starting with the condition nodes visited first, until there are
+	 * at least \p count searches or no search can be branched anymore.
+	 *
+	 * Searches that end before they are branched are done here and store
+	 * their combination in #m_failing if they do not reach the target.
+	 *
+	 * @param net the learning net
+	 * @param graph arrays of the nodes and arcs of \p net, with branch ids
+	 * @param search the search to split
+	 * @param count number of searches to split into
+	 * @return the searches, which have to be continued by searchAllBranches()
+	 */
+	std::vector<Search> splitSearch(const LearningNet &net,
+			const StaticGraph &graph,
+			Search search,
+			std::size_t count)
+	{
+		int elseBranchId = net.getBranchId(CONDITION_ELSE_BRANCH_KEYWORD);
+		std::deque<Search> searches;
+		searches.push_back(std::move(search));
+
+		while (!searches.empty() && searches.size() < count) {
+			Search current = std::move(searches.front());
+			searches.pop_front();
+
+			bool targetReachable = false;
+			int node = searchUntilUnchosen(net, graph, current, targetReachable);
+			if (node < 0) {
+				if (!targetReachable) {
+					storeFailing(current.chosen);
+				}
+				continue;
+			}
+
+			int condition = m_conditionIndex[node];
+			for (std::size_t i = 0; i < m_conditionBranches[condition].size(); i++) {
+				Search branched = current;
+				branched.chosen[condition] = i;
+				if (!precedesFailing(branched.chosen)) {
+					break;
+				}
+
+				// The activations before branching are never undone.
+				branched.incremented.clear();
+				exploreBranch(graph, node, m_conditionBranches[condition][i],
+					elseBranchId, branched);
+				searches.push_back(std::move(branched));
+			}
+		}
+
+		return std::vector<Search>(std::make_move_iterator(searches.begin()),
+			std::make_move_iterator(searches.end()));
+	}
+
+	/**
+	 * Arrays of passes of the bit-sliced search, reused by consecutive passes.
+	 * Passes running in parallel each have their own arrays.
+	 */
+	struct SlicedPass {
+		//! Lanes in which each node is activated, joins only as sources.
+		std::vector<Lanes> activated;
+
+		//! Activated in-arcs of join nodes in each lane.
+		SlicedCounters activatedInArcs;
+
+		//! Lanes choosing each pair of a condition id and a branch id.
+		std::vector<Lanes> selectors;
+	};
+
+	/**
+	 * @param number number of a combination of condition values, counting
+	 * in the order in which pathsForAllConditions() reports combinations
+	 * @return indices of the branches of the combination
+	 */
+	std::vector<int> combination(uint64_t number) const
+	{
+		std::vector<int> combination(m_conditionBranches.size());
+		for (std::size_t i = 0; i < m_conditionBranches.size(); i++) {
+			combination[i] = number % m_conditionBranches[i].size();
+			number /= m_conditionBranches[i].size();
+		}
+		return combination;
+	}
+
+	/**
+	 * Numbers the pairs of condition ids and branch ids, to which the lanes
+	 * of a pass of the bit-sliced search are assigned by selectors.
+	 *
+	 * @param graph arrays of the nodes and arcs of the net, with branch ids
+	 * @return number of selectors
+	 */
+	int numberSelectors(const StaticGraph &graph)
+	{
+		// Branch ids may be listed several times for a condition id.
+		int selectors = 0;
+		std::vector<std::map<int, int>> selectorOfBranch(m_conditionBranches.size());
+		m_branchSelector.clear();
+		for (std::size_t i = 0; i < m_conditionBranches.size(); i++) {
+			m_branchSelector.emplace_back();
+			for (int branch : m_conditionBranches[i]) {
+				if (selectorOfBranch[i].count(branch) == 0) {
+					selectorOfBranch[i][branch] = selectors++;
+				}
+				m_branchSelector[i].push_back(selectorOfBranch[i][branch]);
 			}
+		}
 
-			if (net.isSource(v)) {
-				sources.push_back(v);
+		m_arcSelector.assign(graph.outBegin(m_conditionIndex.size()), -1);
+		for (std::size_t v = 0; v < m_conditionIndex.size(); v++) {
+			if (m_conditionIndex[v] >= 0) {
+				for (int i = graph.outBegin(v); i < graph.outEnd(v); i++) {
+					m_arcSelector[i] =
+						selectorOfBranch[m_conditionIndex[v]].at(graph.branch(i));
+				}
 			}
 		}
+		return selectors;
+	}
 
-		// Function to push an arc's target to sources.
-		auto exploreArc = [&](const lemon::ListDigraph::OutArcIt &a) {
-			lemon::ListDigraph::Node u = net.target(a);
+	/**
+	 * Searches learning paths in \p net for up to LANE_COUNT consecutive
+	 * combinations of condition values at once, in a single pass over the
+	 * nodes in topological order.
+	 *
+	 * Each node is assigned the lanes in which it is activated. A condition
+	 * node passes on each lane only to the out-arcs of the branch chosen in
+	 * the lane, or to its else-branch if it has no out-arc of this branch. A
+	 * join is activated in the lanes in which at least its number of
+	 * necessary in-arcs is activated.
+	 *
+	 * @param net the learning net
+	 * @param graph arrays of the nodes and arcs of \p net, with branch ids
+	 * @param first number of the combination of the first lane
+	 * @param combinations number of all combinations
+	 * @param pass arrays of the pass
+	 * @return the lanes whose combinations have no learning path
+	 */
+	Lanes searchSliced(const LearningNet &net,
+			const StaticGraph &graph,
+			uint64_t first,
+			uint64_t combinations,
+			SlicedPass &pass)
+	{
+		int elseBranchId = net.getBranchId(CONDITION_ELSE_BRANCH_KEYWORD);
+		int maxGradeId = net.getBranchId(MAX_GRADE);
+		int targetId = net.id(net.getTarget());
 
-			if (net.isJoin(u)) {
-				net.incrementActivatedInArcs(u);
+		// Assign the lanes to consecutive combinations.
+		uint64_t lanes = std::min<uint64_t>(LANE_COUNT, combinations - first);
+		Lanes used = lanes == LANE_COUNT ? ~Lanes{0} : (Lanes{1} << lanes) - 1;
+		std::fill(pass.selectors.begin(), pass.selectors.end(), 0);
+		std::vector<int> chosen = combination(first);
+		for (uint64_t lane = 0; lane < lanes; lane++) {
+			for (std::size_t i = 0; i < chosen.size(); i++) {
+				pass.selectors[m_branchSelector[i][chosen[i]]] |= Lanes{1} << lane;
 			}
 
-			if (!net.isJoin(u) ||
-				net.getActivatedInArcs(u) == net.getNecessaryInArcs(u)) {
-				// Push conditions to front, they'll be used after other
-				// nodes such that those nodes are visited less often.
-				if (net.isCondition(u)) {
-					sources.push_front(u);
-				} else {
-					sources.push_back(u);
+			// Count up like an odometer.
+			for (std::size_t i = 0; i < chosen.size(); i++) {
+				if (++chosen[i] < static_cast<int>(m_conditionBranches[i].size())) {
+					break;
 				}
+				chosen[i] = 0;
+			}
+		}
+
+		std::fill(pass.activated.begin(), pass.activated.end(), 0);
+		pass.activatedInArcs.reset();
+		for (int v : m_sources) {
+			pass.activated[v] = used;
+		}
+
+		// Function to pass the lanes of the out-arc with index i in the static
+		// graph on to its target.
+		auto exploreArc = [&](int i, Lanes activated) {
+			int target = graph.target(i);
+			if (graph.hasClass(target, NodeClass::join)) {
+				pass.activatedInArcs.increment(target, activated);
+			} else {
+				pass.activated[target] |= activated;
 			}
 		};
 
-		while (!sources.empty()) {
-			lemon::ListDigraph::Node v = sources.back();
-			sources.pop_back();
+		for (int node : m_topologicalOrder) {
+			// The ref value of a join is its number of necessary in-arcs. As in
+			// the branched search, joins are activated when their counter
+			// reaches it, which never happens if it is 0 (e.g. after
+			// compression), or when they are sources.
+			Lanes activated = pass.activated[node];
+			if (graph.hasClass(node, NodeClass::join) && graph.ref(node) > 0) {
+				activated |= pass.activatedInArcs.atLeast(node, graph.ref(node));
+			}
+			if (activated == 0) {
+				continue;
+			}
 
-			if (v == net.getTarget()) {
-				targetReachable = true;
-				break;
-			} else if (net.isCondition(v)) { // target not yet reachable
-				// Condition: only visit branch given by branchCombination.
-				std::string branch = branchCombination.at(net.getConditionId(v));
-				bool explored = false;
-				lemon::ListDigraph::OutArcIt elseBranch;
-				for (auto a : net.outArcs(v)) {
-					if (net.getConditionBranch(a) == branch) {
-						explored = true;
-						exploreArc(a);
-					} else if (net.getConditionBranch(a) == CONDITION_ELSE_BRANCH_KEYWORD) {
-						elseBranch = a;
+			if (node == targetId) {
+				return used & ~activated;
+			} else if (graph.hasClass(node, NodeClass::condition)) {
+				// Condition: each lane only visits the branch it chose, lanes
+				// without an out-arc of their branch visit the else-branch.
+				Lanes explored = 0;
+				int elseBranch = -1;
+				for (int i = graph.outBegin(node); i < graph.outEnd(node); i++) {
+					Lanes selected = pass.selectors[m_arcSelector[i]];
+					explored |= selected;
+					exploreArc(i, activated & selected);
+					if (graph.branch(i) == elseBranchId) {
+						elseBranch = i;
 					}
 				}
-
-				// If no other branch was visited, the else-branch is explored.
-				if (!explored) {
-					exploreArc(elseBranch);
+				if (elseBranch >= 0) {
+					exploreArc(elseBranch, activated & ~explored);
 				}
-			} else if (net.isTest(v)) {
+			} else if (graph.hasClass(node, NodeClass::test)) {
 				// For a test one of the branches with the highest grade should
 				// lead to the target.
-				for (auto a : net.outArcs(v)) {
-					if (net.getConditionBranch(a) == MAX_GRADE) {
-						exploreArc(a);
+				for (int i = graph.outBegin(node); i < graph.outEnd(node); i++) {
+					if (graph.branch(i) == maxGradeId) {
+						exploreArc(i, activated);
 					}
 				}
 			} else {
-				// Non-Condition/non-test: Push all successors
-				// (unless it is a locked join).
-				for (auto a : net.outArcs(v)) {
-					exploreArc(a);
+				for (int i = graph.outBegin(node); i < graph.outEnd(node); i++) {
+					exploreArc(i, activated);
 				}
 			}
 		}
 
-		return targetReachable;
+		return used;
 	}
 
 	/**
-	 * Executes a learning path search in \p net for each combination of
-	 * condition values as given by a set of values for each condition id.
+	 * Checks all combinations of condition values by passes of the bit-sliced
+	 * search, each pass checking the next LANE_COUNT combinations. If a pool
+	 * is given, the passes are split into ranges run by its workers. Once a
+	 * combination without a learning path is found, all workers skip the
+	 * passes of later combinations.
 	 *
 	 * @param net the learning net
-	 * @param conditionIdToBranches mapping from condition ids to condition values
-	 * @return whether there exists a learning path in \p net for each
-	 * combination of condition values given by \p conditionIdToBranches
+	 * @param graph arrays of the nodes and arcs of \p net, with branch ids
+	 * @param combinations number of all combinations
 	 */
-	void pathsForAllConditions(LearningNet &net,
-			std::map<int, std::vector<std::string>> &conditionIdToBranches)
+	void searchAllSliced(const LearningNet &net,
+			const StaticGraph &graph,
+			uint64_t combinations)
 	{
-		// Start with first branch for every condition.
-		// conditionId -> (iterator in conditionIdToBranches->second)
-		std::map<int, std::vector<std::string>::size_type> branchIndices;
-		for (auto branches : conditionIdToBranches) {
-			branchIndices[std::get<0>(branches)] = 0;
-		}
-
-		// Get first and last condition id in map.
-		int firstId = std::get<0>(*(conditionIdToBranches.cbegin()));
-		int lastId = std::get<0>(*(conditionIdToBranches.crbegin()));
-
-		while (branchIndices[lastId] < conditionIdToBranches[lastId].size()) {
-			std::map<int, std::string> branchCombination;
-			// For each condition id: Dereference branch iterator to get string.
-			for (auto branches : conditionIdToBranches) {
-				int conditionId = std::get<0>(branches);
-				int branchId = branchIndices[conditionId];
-				branchCombination[conditionId] =
-					conditionIdToBranches[conditionId][branchId];
+		int selectors = numberSelectors(graph);
+		std::vector<int> maxCounts(m_conditionIndex.size(), 0);
+		for (std::size_t v = 0; v < maxCounts.size(); v++) {
+			if (graph.hasClass(v, NodeClass::join)) {
+				maxCounts[v] = graph.inDegree(v);
 			}
+		}
 
-			if (!targetReachableByTopSort(net, branchCombination)) {
-				failWithError("No path to target for condition branches:");
-				for (auto branches : conditionIdToBranches) {
-					int conditionId = std::get<0>(branches);
-					appendError(std::to_string(conditionId) + ": " +
-							branchCombination[conditionId]);
+		// Function to run the passes with numbers in [begin, end).
+		auto searchPasses = [&](uint64_t begin, uint64_t end) {
+			SlicedPass pass{
+				std::vector<Lanes>(m_conditionIndex.size(), 0),
+				SlicedCounters(maxCounts),
+				std::vector<Lanes>(selectors, 0)
+			};
+			for (uint64_t i = begin; i < end; i++) {
+				uint64_t first = i * LANE_COUNT;
+				if (!precedesFailing(combination(first))) {
+					return;
 				}
-				return;
+
+				Lanes failing = searchSliced(net, graph, first, combinations, pass);
+				if (failing != 0) {
+					int lane = 0;
+					while (((failing >> lane) & 1) == 0) {
+						lane++;
+					}
+					storeFailing(combination(first + lane));
+					return;
+				}
+			}
+		};
+
+		uint64_t passes = (combinations + LANE_COUNT - 1) / LANE_COUNT;
+		if (m_pool == nullptr || m_pool->size() <= 1) {
+			searchPasses(0, passes);
+		} else {
+			uint64_t ranges = std::min<uint64_t>(passes,
+				m_pool->size() * SEARCHES_PER_WORKER);
+			m_pool->parallelFor(ranges, [&](std::size_t i) {
+				searchPasses(passes * i / ranges, passes * (i + 1) / ranges);
+			});
+		}
+	}
+
+	/**
+	 * Checks that there exists a learning path in \p net for each combination
+	 * of condition values as given by a set of values for each condition id.
+	 * Otherwise this NetworkChecker fails with the first combination without
+	 * a learning path, where the values of the first condition id change
+	 * fastest.
+	 *
+	 * Instead of searching a learning path for each combination, a single
+	 * search is branched at the condition nodes it visits, such that
+	 * condition ids are only distinguished where they matter. If a pool is
+	 * given, the search is split into searches run by its workers. Once a
+	 * combination without a learning path is found, all searches skip the
+	 * branches that can only lead to later combinations, so the same
+	 * combination is reported as without a pool.
+	 *
+	 * @param net the learning net
+	 * @param graph arrays of the nodes and arcs of \p net, with branch ids
+	 * @param conditionIdToBranches mapping from condition ids to branch ids of
+	 * condition values
+	 */
+	void pathsForAllConditions(const LearningNet &net,
+			const StaticGraph &graph,
+			std::map<int, std::vector<int>> &conditionIdToBranches)
+	{
+		// Number the condition ids in the order of the map.
+		std::map<int, int> conditionIndex;
+		m_conditionBranches.clear();
+		for (auto &branches : conditionIdToBranches) {
+			conditionIndex[branches.first] = m_conditionBranches.size();
+			m_conditionBranches.push_back(branches.second);
+		}
+		m_conditionIndex.assign(net.maxNodeId() + 1, -1);
+		for (auto v : net.nodes()) {
+			if (graph.hasClass(net.id(v), NodeClass::condition)) {
+				m_conditionIndex[net.id(v)] = conditionIndex.at(graph.ref(net.id(v)));
+			}
+		}
+		m_failing.clear();
+
+		// Checking every combination only pays off while there are few.
+		uint64_t combinations = 1;
+		for (auto &branches : m_conditionBranches) {
+			combinations *= branches.size();
+			if (combinations > m_maxSlicedCombinations) {
+				break;
 			}
+		}
 
-			// Get next combination of condition branches:
-			// Increment the branch of the current condition.
-			branchIndices[firstId]++;
-
-			// Work similar to an odometer:
-			// If the iterator reaches the end of the branches for this
-			// condition, reset them and increment the branches for next one.
-			// Repeat this process until one iterator does not reach the end for
-			// the respective condition anymore.
-			auto id = conditionIdToBranches.begin();
-			int currentId = std::get<0>(*id);
-			while (
-				currentId != lastId &&
-				branchIndices[currentId] == conditionIdToBranches[currentId].size())
-			{
-				branchIndices[currentId] = 0;
-				id++;
-				currentId = std::get<0>(*id);
-				branchIndices[currentId]++;
+		if (combinations <= m_maxSlicedCombinations) {
+			searchAllSliced(net, graph, combinations);
+		} else if (m_pool == nullptr || m_pool->size() <= 1) {
+			Search search = startSearch(net);
+			searchAllBranches(net, graph, search);
+		} else {
+			std::vector<Search> searches = splitSearch(net, graph,
+				startSearch(net), m_pool->size() * SEARCHES_PER_WORKER);
+			m_pool->parallelFor(searches.size(), [&](std::size_t i) {
+				if (precedesFailing(searches[i].chosen)) {
+					searchAllBranches(net, graph, searches[i]);
+				}
+			});
+		}
+
+		if (!m_failing.empty()) {
+			failWithError("No path to target for condition branches:");
+			for (auto &branches : conditionIdToBranches) {
+				int i = conditionIndex[branches.first];
+				appendError(std::to_string(branches.first) + ": " +
+					net.getBranchName(m_conditionBranches[i][m_failing[i]]));
 			}
 		}
 	}
@@ -214,13 +725,19 @@ private:
 		conditionsExist = false;
 		testsExist = false;
 
+		std::shared_ptr<const StaticGraph> staticGraph = net.getStaticGraph();
+		const StaticGraph &graph = *staticGraph;
 		std::map<int, bool> sectionExists;
 		for (auto v : net.nodes()) {
+			int node = net.id(v);
+			int inArcs = graph.inDegree(node);
+			int outArcs = graph.outDegree(node);
+			int nodeClass = graph.nodeClass(node);
+
 			// Check number of in-/out-arcs for each node-type.
-			if (net.isUnit(v)) {
+			if (nodeClass & NodeClass::unit) {
 				int section = net.getSection(v);
-				if (!hasAtMostOneArc<lemon::ListDigraph::OutArcIt>(net, v) ||
-				    !hasAtMostOneArc<lemon::ListDigraph::InArcIt>(net, v)) {
+				if (outArcs > 1 || inArcs > 1) {
 					failWithError("Unit node of section " + std::to_string(section)
 						+ " has more than one in-arc or out-arc.");
 				}
@@ -232,17 +749,17 @@ private:
 				}
 				sectionExists[section] = true;
 
-			} else if (net.isJoin(v)) {
-				if (net.isSource(v)) {
+			} else if (nodeClass & NodeClass::join) {
+				if (inArcs == 0) {
 					failWithError("Join node has no in-arc.");
 				}
-				if (!hasAtMostOneArc<lemon::ListDigraph::OutArcIt>(net, v)) {
+				if (outArcs > 1) {
 					failWithError("Join node has more than one out-arc.");
 				}
 
 				// Necessary inarcs of a join are less than actual InArcs.
 				int necessaryInArcs = net.getNecessaryInArcs(v);
-				int actualInArcs = countInArcs(net, v);
+				int actualInArcs = inArcs;
 				if (necessaryInArcs == 0) {
 					failWithError("Join node has necessary in-arcs set to 0.");
 				}
@@ -252,23 +769,23 @@ private:
 						" actual in-arcs.");
 				}
 
-			} else if (net.isSplit(v)) {
-				if (!hasAtMostOneArc<lemon::ListDigraph::InArcIt>(net, v)) {
+			} else if (nodeClass & NodeClass::split) {
+				if (inArcs > 1) {
 					failWithError("Split node has more than one in-arc.");
 				}
 
-			} else if (net.isCondition(v)) {
+			} else if (nodeClass & NodeClass::condition) {
 				conditionsExist = true;
-				if (!hasAtMostOneArc<lemon::ListDigraph::InArcIt>(net, v)) {
+				if (inArcs > 1) {
 					failWithError("Condition node has more than one in-arc.");
 				}
 
 				// Check that each condition has an else-branch (otherwise it
 				// might not always be possible to reach the target).
+				int elseBranchId = net.getBranchId(CONDITION_ELSE_BRANCH_KEYWORD);
 				bool elseBranchFound = false;
-				for (auto out : net.outArcs(v)) {
-					std::string conditionBranch = net.getConditionBranch(out);
-					if (conditionBranch == CONDITION_ELSE_BRANCH_KEYWORD) {
+				for (int i = graph.outBegin(net.id(v)); i < graph.outEnd(net.id(v)); i++) {
+					if (graph.branch(i) == elseBranchId) {
 						elseBranchFound = true;
 						break;
 					}
@@ -277,9 +794,9 @@ private:
 					failWithError("Condition has no else branch.");
 				}
 
-			} else if (net.isTest(v)) {
+			} else if (nodeClass & NodeClass::test) {
 				testsExist = true;
-				if (!hasAtMostOneArc<lemon::ListDigraph::InArcIt>(net, v)) {
+				if (inArcs > 1) {
 					failWithError("Test node has more than one in-arc.");
 				}
 			} else {
@@ -295,12 +812,13 @@ private:
 	 * branches for the given condition id is applicable for the user).
 	 *
 	 * @param net learning net in which to collect condition branches
-	 * @return map from condition ids to arrays of strings (condition values)
+	 * @return map from condition ids to arrays of branch ids (of condition
+	 * values)
 	 */
-	std::map<int, std::vector<std::string>> getConditionBranches(
+	std::map<int, std::vector<int>> getConditionBranches(
 			const LearningNet &net) const
 	{
-		std::map<int, std::vector<std::string>> conditionIdToBranches;
+		std::map<int, std::vector<int>> conditionIdToBranches;
 		for (auto v : net.nodes()) {
 			if (net.isCondition(v)) {
 				int conditionId = net.getConditionId(v);
@@ -308,11 +826,11 @@ private:
 				for (auto out : net.outArcs(v)) {
 					if (conditionIdToBranches.find(conditionId) ==
 						conditionIdToBranches.end()) {
-						std::vector<std::string> branches;
+						std::vector<int> branches;
 						conditionIdToBranches[conditionId] = branches;
 					}
 					conditionIdToBranches[conditionId].push_back(
-						net.getConditionBranch(out)
+						net.getConditionBranchId(out)
 					);
 				}
 			}
@@ -320,7 +838,7 @@ private:
 
 		// Make collected condition branches unique.
 		for (auto idToBranches : conditionIdToBranches) {
-			std::vector<std::string> branches = std::get<1>(idToBranches);
+			std::vector<int> branches = std::get<1>(idToBranches);
 			auto last = std::unique(branches.begin(), branches.end());
 			branches.erase(last, branches.end());
 			conditionIdToBranches[std::get<0>(idToBranches)] = branches;
@@ -347,7 +865,7 @@ private:
 			return;
 		}
 
-		if (!dag(net)) {
+		if (!net.isAcyclic()) {
 			// Fail if the network is not acylic.
 			failWithError("Given network is not acyclic.");
 			return;
@@ -356,31 +874,43 @@ private:
 			return;
 		}
 
+		// Test grades are compared as numbers, so fail if one is no number.
+		std::shared_ptr<const StaticGraph> gradedGraph = net.getStaticGraph();
+		std::shared_ptr<const GradeTable> grades = net.getGradeTable();
+		if (grades->ungradedNode() >= 0) {
+			failWithError("Test node with test id " +
+				std::to_string(net.getTestId(net.nodeFromId(grades->ungradedNode()))) +
+				" has a grade that is no number.");
+			return;
+		}
+
 		// For test grades, set highest test grades to MAX_GRADE, others to 0.
 		// This later simplifies checking whether a test grade is the highest.
+		// The grade table of the net is discarded once a grade is changed, so
+		// collect the highest grades before changing any grade.
+		std::vector<lemon::ListDigraph::Arc> testBranches;
+		std::vector<lemon::ListDigraph::Arc> highestGradeBranches;
 		for (auto v : net.nodes()) {
 			if (net.isTest(v)) {
-				std::vector<lemon::ListDigraph::OutArcIt> highestGradeBranches;
-				int maxGrade = -1;
-				for (auto a : net.outArcs(v)) {
-					int branchGrade = std::stoi(net.getConditionBranch(a));
-					if (branchGrade >= maxGrade) {
-						if (branchGrade > maxGrade) {
-							maxGrade = branchGrade;
-							highestGradeBranches.clear();
-						}
+				ArrayView<GradedArc> arcs = grades->gradedArcs(net.id(v));
+				for (std::size_t i = 0; i < arcs.size(); i++) {
+					auto a = net.arcFromId(gradedGraph->arc(arcs[i].arc));
+					testBranches.push_back(a);
+					if (static_cast<int>(i) >= grades->maxGradeBegin(net.id(v))) {
 						highestGradeBranches.push_back(a);
 					}
-
-					net.setConditionBranch(a, "0");
-				}
-
-				for (auto a : highestGradeBranches) {
-					net.setConditionBranch(a, MAX_GRADE);
 				}
 			}
 		}
 
+		for (auto a : testBranches) {
+			net.setConditionBranch(a, "0");
+		}
+
+		for (auto a : highestGradeBranches) {
+			net.setConditionBranch(a, MAX_GRADE);
+		}
+
 		// If compression should be used, compress the network.
 		if (m_useCompression) {
 			Compressor comp{net};
@@ -408,11 +938,37 @@ private:
 			}
 		}
 
+		// The net may have been changed by the compression, so the arrays for
+		// the learning path searches are built only now.
+		StaticGraph graph = net.buildStaticGraph();
+		m_sources.clear();
+		for (auto v : net.nodes()) {
+			if (graph.inDegree(net.id(v)) == 0) {
+				m_sources.push_back(net.id(v));
+			}
+		}
+
+		// The net is acyclic, so all nodes are sorted.
+		std::vector<int> remainingInArcs(net.maxNodeId() + 1, 0);
+		m_topologicalOrder = m_sources;
+		for (std::size_t k = 0; k < m_topologicalOrder.size(); k++) {
+			int v = m_topologicalOrder[k];
+			for (int i = graph.outBegin(v); i < graph.outEnd(v); i++) {
+				int u = graph.target(i);
+				if (++remainingInArcs[u] == graph.inDegree(u)) {
+					m_topologicalOrder.push_back(u);
+				}
+			}
+		}
+
 		if (!conditionsExist) {
 			if (testsExist) {
 				// If there are no conditions but tests, run learning path
 				// search once.
-				if (!targetReachableByTopSort(net, {})) {
+				Search search = startSearch(net);
+				bool targetReachable = false;
+				searchUntilUnchosen(net, graph, search, targetReachable);
+				if (!targetReachable) {
 					failWithError("The target cannot be reached when getting "
 						"the highest grade in every test.");
 				}
@@ -423,22 +979,44 @@ private:
 		}
 
 		// Conditions exist, there must exist a path to target for each branch.
-		std::map<int, std::vector<std::string>> conditionBranches =
+		std::map<int, std::vector<int>> conditionBranches =
 			getConditionBranches(net);
-		pathsForAllConditions(net, conditionBranches);
+		pathsForAllConditions(net, graph, conditionBranches);
 	}
 
 public:
+	//! Default of the largest number of combinations of condition values
+	//! checked by the bit-sliced search, i.e. by at most 64 passes.
+	static constexpr uint64_t MAX_SLICED_COMBINATIONS = 64 * LANE_COUNT;
+
 	/**
 	 * Creates a NetworkChecker and checks the given directed graph.
 	 *
 	 * @param net the learning net to check
 	 * @param useCompression whether the graph should be compressed before
 	 * searching learning paths
+	 * @param pool pool whose workers search learning paths for different
+	 * condition values in parallel if given
+	 * @param maxSlicedCombinations largest number of combinations of
+	 * condition values that are all checked by the bit-sliced search, more
+	 * are checked by a search branched at the condition nodes it visits
 	 */
-	NetworkChecker(LearningNet &net, bool useCompression = true)
+	NetworkChecker(LearningNet &net,
+			bool useCompression = true,
+			ThreadPool *pool = nullptr,
+			uint64_t maxSlicedCombinations = MAX_SLICED_COMBINATIONS)
 		: Module()
 		, m_useCompression{useCompression}
+		, m_pool{pool}
+		, m_maxSlicedCombinations{maxSlicedCombinations}
+		, m_sources{}
+		, m_topologicalOrder{}
+		, m_conditionIndex{}
+		, m_conditionBranches{}
+		, m_branchSelector{}
+		, m_arcSelector{}
+		, m_failing{}
+		, m_failingMutex{}
 	{
 		call(net);
 	}
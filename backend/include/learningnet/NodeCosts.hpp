@@ -0,0 +1,99 @@
+#pragma once
+
+#include <lemon/list_graph.h>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Costs of the unit nodes of a learning net, stored densely and indexed by
+ * node ids such that looking up a cost is a single array access.
+ *
+ * Nodes without a cost (e.g. connectives) hold NaN. #at() always checks that a
+ * node has a cost, #operator[]() only does so if LN_DEBUG_COSTS is defined.
+ */
+class NodeCosts
+{
+private:
+	std::vector<double> m_costs; //!< cost of each node id, NaN if there is none
+
+	/**
+	 * @param v the node
+	 * @throws std::out_of_range if \p v has no cost
+	 */
+	void check(const lemon::ListDigraph::Node &v) const {
+		if (!hasCost(v)) {
+			throw std::out_of_range("No cost for node " +
+				std::to_string(lemon::ListDigraph::id(v)) + ".");
+		}
+	}
+
+public:
+	/**
+	 * Creates NodeCosts without any costs.
+	 */
+	NodeCosts() : m_costs{} {}
+
+	/**
+	 * Creates NodeCosts for the nodes of \p net, none of which has a cost yet.
+	 *
+	 * @param net the learning net
+	 */
+	explicit NodeCosts(const lemon::ListDigraph &net)
+		: m_costs(net.maxNodeId() + 1, std::numeric_limits<double>::quiet_NaN())
+	{}
+
+	/**
+	 * @param v the node
+	 * @return whether a cost is set for \p v
+	 */
+	bool hasCost(const lemon::ListDigraph::Node &v) const {
+		int id = lemon::ListDigraph::id(v);
+		return id >= 0 && static_cast<std::size_t>(id) < m_costs.size()
+			&& m_costs[id] == m_costs[id];
+	}
+
+	/**
+	 * @param v a node of the net these costs were created for
+	 * @return reference to the cost of \p v, which is set to 0 first if \p v
+	 * had no cost
+	 */
+	double &operator[](const lemon::ListDigraph::Node &v) {
+#ifdef LN_DEBUG_COSTS
+		if (static_cast<std::size_t>(lemon::ListDigraph::id(v)) >= m_costs.size()) {
+			check(v);
+		}
+#endif
+		double &cost = m_costs[lemon::ListDigraph::id(v)];
+		if (cost != cost) {
+			cost = 0.0;
+		}
+		return cost;
+	}
+
+	/**
+	 * @param v a node with a cost
+	 * @return the cost of \p v
+	 */
+	double operator[](const lemon::ListDigraph::Node &v) const {
+#ifdef LN_DEBUG_COSTS
+		check(v);
+#endif
+		return m_costs[lemon::ListDigraph::id(v)];
+	}
+
+	/**
+	 * @param v the node
+	 * @return the cost of \p v
+	 * @throws std::out_of_range if \p v has no cost
+	 */
+	double at(const lemon::ListDigraph::Node &v) const {
+		check(v);
+		return m_costs[lemon::ListDigraph::id(v)];
+	}
+};
+
+}
@@ -0,0 +1,532 @@
+#pragma once
+
+#include <learningnet/LearningNet.hpp>
+#include <learningnet/PairCostKernel.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Costs of the pairs of unit nodes of a learning net.
+ *
+ * Unit nodes are numbered by their unit index in the SectionIndex of the net,
+ * which is dense and follows the order of their node ids. The costs are stored in one of the following ways (see Storage):
+ * - in a row-major matrix of doubles with one row per unit node,
+ * - in compressed sparse rows holding the columns with a cost sorted by unit
+ *   index, if only few pairs have a cost, or
+ * - in a row-major matrix of 8 or 16 bit codes, if every cost is an integer
+ *   multiple of a common quantum. A code c stands for the cost
+ *   (c * quantum) / divisor, such that comparing costs compares their codes.
+ *
+ * Costs of symmetric cost functions, which are equal for both orders of a
+ * pair, are kept apart in a packed upper triangular matrix and added to the
+ * costs above. So are the costs of PairCostKernels, which are computed when
+ * they are needed. Pairs without a cost cost 0. A Row of costs can be scanned
+ * linearly when comparing the costs from one unit node to many others.
+ *
+ * Looking up a node that is no unit node is only checked if LN_DEBUG_COSTS is
+ * defined.
+ */
+class NodePairCosts
+{
+private:
+	std::shared_ptr<const SectionIndex> m_units; //!< unit index of each unit node
+
+	int m_unitCount; //!< number of unit nodes
+
+public:
+	//! Ways to store the costs.
+	enum class Storage {
+		matrix, //!< matrix of doubles
+		sparse, //!< compressed sparse rows of doubles
+		quantized8, //!< matrix of 8 bit codes
+		quantized16 //!< matrix of 16 bit codes
+	};
+
+private:
+	Storage m_storage; //!< how the costs are stored
+
+	//! costs of all pairs in a row-major matrix for Storage::matrix
+	std::vector<double> m_matrix;
+
+	//! index of the first entry of each row in #m_column and #m_cost, followed
+	//! by the number of entries, for Storage::sparse
+	std::vector<int> m_rowBegin;
+
+	std::vector<int> m_column; //!< unit index of each entry, Storage::sparse
+
+	std::vector<double> m_cost; //!< cost of each entry, Storage::sparse
+
+	//! codes of all pairs in a row-major matrix for Storage::quantized8
+	std::vector<uint8_t> m_codes8;
+
+	//! codes of all pairs in a row-major matrix for Storage::quantized16
+	std::vector<uint16_t> m_codes16;
+
+	double m_quantum; //!< cost of code 1 times #m_divisor
+
+	double m_divisor; //!< divisor of the costs of codes
+
+	//! costs of symmetric cost functions of the pairs of unit indices i < j
+	//! in a packed upper triangular matrix without the diagonal, row by row,
+	//! empty if there are none
+	std::vector<double> m_symmetric;
+
+	//! cost functions computed from attributes of the unit nodes
+	std::vector<PairCostKernel> m_kernels;
+
+	/**
+	 * @param i unit index
+	 * @param j unit index other than \p i
+	 * @return index of the pair of \p i and \p j in #m_symmetric
+	 */
+	std::size_t triangleIndex(int i, int j) const {
+		if (i > j) {
+			std::swap(i, j);
+		}
+		return static_cast<std::size_t>(i) * (2 * m_unitCount - i - 1) / 2 + (j - i - 1);
+	}
+
+	/**
+	 * @param code code of a cost
+	 * @return the cost
+	 */
+	double dequantize(uint64_t code) const {
+		return (code * m_quantum) / m_divisor;
+	}
+
+	/**
+	 * @param v the node
+	 * @return unit index of \p v
+	 */
+	int index(const lemon::ListDigraph::Node &v) const {
+#ifdef LN_DEBUG_COSTS
+		int id = lemon::ListDigraph::id(v);
+		if (m_units->unitIndex(id) < 0) {
+			throw std::out_of_range("No costs for node " + std::to_string(id) + ".");
+		}
+#endif
+		return m_units->unitIndex(lemon::ListDigraph::id(v));
+	}
+
+	/**
+	 * Numbers the unit nodes of \p net without allocating any costs.
+	 *
+	 * @param net the learning net
+	 */
+	NodePairCosts(const LearningNet &net, int)
+		: NodePairCosts()
+	{
+		m_units = net.getSectionIndex();
+		m_unitCount = m_units->unitCount();
+	}
+
+public:
+	/**
+	 * Costs from one unit node to all unit nodes.
+	 */
+	class Row
+	{
+	private:
+		const NodePairCosts *m_costs; //!< costs this row belongs to
+
+		int m_row; //!< unit index of this row
+
+		const double *m_dense; //!< costs of the row, Storage::matrix
+
+		const int *m_column; //!< sorted unit indices of the entries, Storage::sparse
+
+		const double *m_cost; //!< costs of the entries, Storage::sparse
+
+		int m_size; //!< number of entries, Storage::sparse
+
+		const uint8_t *m_codes8; //!< codes of the row, Storage::quantized8
+
+		const uint16_t *m_codes16; //!< codes of the row, Storage::quantized16
+
+	public:
+		/**
+		 * @param costs the costs this row belongs to
+		 * @param row unit index of the row
+		 */
+		Row(const NodePairCosts &costs, int row)
+			: m_costs{&costs}
+			, m_row{row}
+			, m_dense{nullptr}
+			, m_column{nullptr}
+			, m_cost{nullptr}
+			, m_size{0}
+			, m_codes8{nullptr}
+			, m_codes16{nullptr}
+		{
+			std::size_t begin = static_cast<std::size_t>(row) * costs.m_unitCount;
+			switch (costs.m_storage) {
+				case Storage::matrix:
+					m_dense = costs.m_matrix.data() + begin;
+					break;
+				case Storage::sparse:
+					m_column = costs.m_column.data() + costs.m_rowBegin[row];
+					m_cost = costs.m_cost.data() + costs.m_rowBegin[row];
+					m_size = costs.m_rowBegin[row + 1] - costs.m_rowBegin[row];
+					break;
+				case Storage::quantized8:
+					m_codes8 = costs.m_codes8.data() + begin;
+					break;
+				case Storage::quantized16:
+					m_codes16 = costs.m_codes16.data() + begin;
+					break;
+			}
+		}
+
+		/**
+		 * @param w a unit node
+		 * @return the cost of the pair of the node of this row and \p w
+		 */
+		double operator[](const lemon::ListDigraph::Node &w) const {
+			int column = m_costs->index(w);
+			double cost = asymmetric(column);
+			if (column == m_row) {
+				return cost;
+			}
+			if (!m_costs->m_symmetric.empty()) {
+				cost += m_costs->m_symmetric[m_costs->triangleIndex(m_row, column)];
+			}
+			for (const PairCostKernel &kernel : m_costs->m_kernels) {
+				cost += kernel(m_row, column);
+			}
+			return cost;
+		}
+
+		/**
+		 * @return sum of the costs in this row, in the order of unit indices
+		 */
+		double sum() const {
+			double sum = asymmetricSum();
+			if (!m_costs->m_symmetric.empty()) {
+				double symmetricSum = 0.0;
+				for (int i = 0; i < m_costs->m_unitCount; i++) {
+					if (i != m_row) {
+						symmetricSum += m_costs->m_symmetric[m_costs->triangleIndex(m_row, i)];
+					}
+				}
+				sum += symmetricSum;
+			}
+			for (const PairCostKernel &kernel : m_costs->m_kernels) {
+				double kernelSum = 0.0;
+				for (int i = 0; i < m_costs->m_unitCount; i++) {
+					if (i != m_row) {
+						kernelSum += kernel(m_row, i);
+					}
+				}
+				sum += kernelSum;
+			}
+			return sum;
+		}
+
+	private:
+		/**
+		 * @param column unit index
+		 * @return the cost without symmetric cost functions of the pair of
+		 * the node of this row and the node with unit index \p column
+		 */
+		double asymmetric(int column) const {
+			switch (m_costs->m_storage) {
+				case Storage::matrix:
+					return m_dense[column];
+				case Storage::quantized8:
+					return m_costs->dequantize(m_codes8[column]);
+				case Storage::quantized16:
+					return m_costs->dequantize(m_codes16[column]);
+				default:
+					break;
+			}
+			const int *found = std::lower_bound(m_column, m_column + m_size, column);
+			return found != m_column + m_size && *found == column ?
+				m_cost[found - m_column] : 0.0;
+		}
+
+		/**
+		 * @return sum of the costs without symmetric cost functions in this
+		 * row, in the order of unit indices
+		 */
+		double asymmetricSum() const {
+			double sum = 0.0;
+			uint64_t codeSum = 0;
+			switch (m_costs->m_storage) {
+				case Storage::matrix:
+					for (int i = 0; i < m_costs->m_unitCount; i++) {
+						sum += m_dense[i];
+					}
+					return sum;
+				case Storage::sparse:
+					for (int i = 0; i < m_size; i++) {
+						sum += m_cost[i];
+					}
+					return sum;
+				case Storage::quantized8:
+					// Codes are added up exactly before dequantizing them.
+					for (int i = 0; i < m_costs->m_unitCount; i++) {
+						codeSum += m_codes8[i];
+					}
+					break;
+				case Storage::quantized16:
+					for (int i = 0; i < m_costs->m_unitCount; i++) {
+						codeSum += m_codes16[i];
+					}
+					break;
+			}
+			return m_costs->dequantize(codeSum);
+		}
+	};
+
+	/**
+	 * Creates NodePairCosts without any unit nodes.
+	 */
+	NodePairCosts()
+		: m_units{std::make_shared<const SectionIndex>()}
+		, m_unitCount{0}
+		, m_storage{Storage::matrix}
+		, m_matrix{}
+		, m_rowBegin{0}
+		, m_column{}
+		, m_cost{}
+		, m_codes8{}
+		, m_codes16{}
+		, m_quantum{1.0}
+		, m_divisor{1.0}
+		, m_symmetric{}
+		, m_kernels{}
+	{}
+
+	/**
+	 * Creates NodePairCosts for the unit nodes of \p net in which every pair
+	 * costs 0, stored in a matrix.
+	 *
+	 * @param net the learning net
+	 */
+	explicit NodePairCosts(const LearningNet &net)
+		: NodePairCosts(net, 0)
+	{
+		m_matrix.assign(static_cast<std::size_t>(m_unitCount) * m_unitCount, 0.0);
+	}
+
+	/**
+	 * Creates NodePairCosts for the unit nodes of \p net from the costs of
+	 * some pairs, stored in compressed sparse rows. All other pairs cost 0.
+	 *
+	 * @param net the learning net
+	 * @param entries pairs of unit nodes and their costs, the costs of equal
+	 * pairs are added up in the given order
+	 * @return the costs
+	 */
+	static NodePairCosts sparse(const LearningNet &net,
+			const std::vector<std::tuple<lemon::ListDigraph::Node,
+				lemon::ListDigraph::Node, double>> &entries)
+	{
+		NodePairCosts costs{net, 0};
+		costs.m_storage = Storage::sparse;
+
+		// Sort the entries by unit indices, equal pairs stay in order.
+		std::vector<std::tuple<int, int, double>> indexed;
+		indexed.reserve(entries.size());
+		for (auto &entry : entries) {
+			indexed.emplace_back(costs.index(std::get<0>(entry)),
+				costs.index(std::get<1>(entry)), std::get<2>(entry));
+		}
+		std::stable_sort(indexed.begin(), indexed.end(),
+			[](const std::tuple<int, int, double> &x,
+					const std::tuple<int, int, double> &y) {
+				return std::tie(std::get<0>(x), std::get<1>(x)) <
+					std::tie(std::get<0>(y), std::get<1>(y));
+			});
+
+		costs.m_rowBegin.assign(costs.m_unitCount + 1, 0);
+		for (std::size_t i = 0; i < indexed.size(); i++) {
+			int row = std::get<0>(indexed[i]);
+			int column = std::get<1>(indexed[i]);
+			if (i > 0 && std::get<0>(indexed[i - 1]) == row &&
+					std::get<1>(indexed[i - 1]) == column) {
+				costs.m_cost.back() += std::get<2>(indexed[i]);
+			} else {
+				costs.m_column.push_back(column);
+				costs.m_cost.push_back(std::get<2>(indexed[i]));
+				costs.m_rowBegin[row + 1]++;
+			}
+		}
+		for (int row = 0; row < costs.m_unitCount; row++) {
+			costs.m_rowBegin[row + 1] += costs.m_rowBegin[row];
+		}
+		return costs;
+	}
+
+	/**
+	 * Creates NodePairCosts for the unit nodes of \p net in which every pair
+	 * has code 0, stored in a matrix of 8 bit codes if \p maxCode fits into
+	 * them and 16 bit codes otherwise.
+	 *
+	 * @param net the learning net
+	 * @param maxCode the highest code of any pair after all calls of
+	 * #addCode()
+	 * @param quantum cost of code 1 times \p divisor
+	 * @param divisor divisor of the costs of codes
+	 * @return the costs
+	 * @throws std::invalid_argument if \p maxCode does not fit into 16 bits
+	 */
+	static NodePairCosts quantized(const LearningNet &net,
+			uint32_t maxCode,
+			double quantum,
+			double divisor)
+	{
+		if (maxCode > UINT16_MAX) {
+			throw std::invalid_argument("Node pair cost codes do not fit into 16 bits.");
+		}
+
+		NodePairCosts costs{net, 0};
+		costs.m_quantum = quantum;
+		costs.m_divisor = divisor;
+		std::size_t size = static_cast<std::size_t>(costs.m_unitCount) * costs.m_unitCount;
+		if (maxCode <= UINT8_MAX) {
+			costs.m_storage = Storage::quantized8;
+			costs.m_codes8.assign(size, 0);
+		} else {
+			costs.m_storage = Storage::quantized16;
+			costs.m_codes16.assign(size, 0);
+		}
+		return costs;
+	}
+
+	/**
+	 * @return number of unit nodes
+	 */
+	int unitCount() const {
+		return m_unitCount;
+	}
+
+	/**
+	 * @param v a node
+	 * @return unit index of \p v, -1 if \p v is no unit node
+	 */
+	int unitIndex(const lemon::ListDigraph::Node &v) const {
+		return m_units->unitIndex(lemon::ListDigraph::id(v));
+	}
+
+	/**
+	 * @return how the costs are stored
+	 */
+	Storage getStorage() const {
+		return m_storage;
+	}
+
+	/**
+	 * @param v a unit node
+	 * @return the costs from \p v to all unit nodes
+	 */
+	Row row(const lemon::ListDigraph::Node &v) const {
+		return Row(*this, index(v));
+	}
+
+	/**
+	 * @param v a unit node
+	 * @param w a unit node
+	 * @return the cost of the pair of \p v and \p w
+	 */
+	double operator()(const lemon::ListDigraph::Node &v,
+			const lemon::ListDigraph::Node &w) const {
+		return row(v)[w];
+	}
+
+	/**
+	 * Adds to the cost of a pair of unit nodes.
+	 *
+	 * @param v a unit node
+	 * @param w a unit node
+	 * @param cost the cost added to the cost of the pair of \p v and \p w
+	 * @throws std::logic_error if the costs are not stored in a matrix of
+	 * doubles
+	 */
+	void add(const lemon::ListDigraph::Node &v,
+			const lemon::ListDigraph::Node &w,
+			double cost) {
+		if (m_storage != Storage::matrix) {
+			throw std::logic_error("Only node pair costs in a matrix can be changed.");
+		}
+		m_matrix[static_cast<std::size_t>(index(v)) * m_unitCount + index(w)] += cost;
+	}
+
+	/**
+	 * Adds to the costs of a symmetric cost function of a pair of unit nodes,
+	 * which then cost as much in both orders.
+	 *
+	 * @param v a unit node
+	 * @param w a unit node other than \p v
+	 * @param cost the cost added to the pair of \p v and \p w as well as to
+	 * the pair of \p w and \p v
+	 * @throws std::invalid_argument if \p v and \p w are equal
+	 */
+	void addSymmetric(const lemon::ListDigraph::Node &v,
+			const lemon::ListDigraph::Node &w,
+			double cost) {
+		if (v == w) {
+			throw std::invalid_argument("Symmetric node pair costs need two nodes.");
+		}
+		if (m_symmetric.empty()) {
+			m_symmetric.assign(
+				static_cast<std::size_t>(m_unitCount) * (m_unitCount - 1) / 2, 0.0);
+		}
+		m_symmetric[triangleIndex(index(v), index(w))] += cost;
+	}
+
+	/**
+	 * @return whether costs of symmetric cost functions were added
+	 */
+	bool hasSymmetric() const {
+		return !m_symmetric.empty();
+	}
+
+	/**
+	 * Adds a cost function that is computed from attributes of the unit nodes
+	 * to the costs of all pairs.
+	 *
+	 * @param kernel the cost function, with one attribute for each unit index
+	 */
+	void addKernel(PairCostKernel kernel) {
+		m_kernels.push_back(std::move(kernel));
+	}
+
+	/**
+	 * Adds to the code of a pair of unit nodes.
+	 *
+	 * @param v a unit node
+	 * @param w a unit node
+	 * @param code the code added to the code of the pair of \p v and \p w
+	 * @throws std::logic_error if the costs are not quantized
+	 * @throws std::overflow_error if the new code does not fit
+	 */
+	void addCode(const lemon::ListDigraph::Node &v,
+			const lemon::ListDigraph::Node &w,
+			uint32_t code) {
+		std::size_t i = static_cast<std::size_t>(index(v)) * m_unitCount + index(w);
+		if (m_storage == Storage::quantized8) {
+			if (code > static_cast<uint32_t>(UINT8_MAX - m_codes8[i])) {
+				throw std::overflow_error("Node pair cost code does not fit into 8 bits.");
+			}
+			m_codes8[i] += code;
+		} else if (m_storage == Storage::quantized16) {
+			if (code > static_cast<uint32_t>(UINT16_MAX - m_codes16[i])) {
+				throw std::overflow_error("Node pair cost code does not fit into 16 bits.");
+			}
+			m_codes16[i] += code;
+		} else {
+			throw std::logic_error("Only quantized node pair costs have codes.");
+		}
+	}
+};
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Weighted node pair cost function that is computed from one attribute of
+ * each unit node when a cost is needed, instead of being stored for every
+ * pair. Unit nodes are referred to by their unit index, see NodePairCosts.
+ *
+ * The cost of a pair of unit nodes with attributes x and y is
+ * (k(x, y) * weight) / divisor, where k is given by the Kind of the kernel.
+ * Pairs in which a unit node has no attribute cost 0.
+ */
+class PairCostKernel
+{
+public:
+	//! Kernels k computing the cost of a pair from its attributes x and y.
+	enum class Kind {
+		absoluteDifference, //!< scale * |x - y|
+		squaredDifference, //!< scale * (x - y)^2
+		threshold //!< scale if |x - y| > threshold, 0 otherwise
+	};
+
+private:
+	Kind m_kind; //!< kernel
+
+	double m_scale; //!< factor of the kernel
+
+	double m_threshold; //!< threshold of Kind::threshold
+
+	double m_weight; //!< weight of the cost function
+
+	double m_divisor; //!< divisor of the weighted kernel, e.g. the weight sum
+
+	std::vector<double> m_attribute; //!< attribute of each unit index or NaN
+
+public:
+	/**
+	 * @param kind the kernel
+	 * @param scale factor of the kernel
+	 * @param threshold threshold of Kind::threshold, ignored otherwise
+	 * @param weight weight of the cost function
+	 * @param divisor divisor of the weighted kernel, e.g. the weight sum
+	 * @param attributes attribute of each unit index, NaN for unit nodes
+	 * without one
+	 */
+	PairCostKernel(Kind kind,
+			double scale,
+			double threshold,
+			double weight,
+			double divisor,
+			std::vector<double> attributes)
+		: m_kind{kind}
+		, m_scale{scale}
+		, m_threshold{threshold}
+		, m_weight{weight}
+		, m_divisor{divisor}
+		, m_attribute(std::move(attributes))
+	{}
+
+	/**
+	 * @param i unit index
+	 * @param j unit index
+	 * @return the cost of the pair of the unit nodes with indices \p i and \p j
+	 */
+	double operator()(int i, int j) const {
+		double x = m_attribute[i];
+		double y = m_attribute[j];
+		if (std::isnan(x) || std::isnan(y)) {
+			return 0.0;
+		}
+
+		double cost = 0.0;
+		switch (m_kind) {
+			case Kind::absoluteDifference:
+				cost = std::fabs(x - y) * m_scale;
+				break;
+			case Kind::squaredDifference:
+				cost = (x - y) * (x - y) * m_scale;
+				break;
+			case Kind::threshold:
+				cost = std::fabs(x - y) > m_threshold ? m_scale : 0.0;
+				break;
+		}
+		return (cost * m_weight) / m_divisor;
+	}
+};
+
+}
@@ -1,18 +1,17 @@
 #pragma once
 #include <learningnet/Module.hpp>
 #include <learningnet/LearningNet.hpp>
+#include <learningnet/LearnerState.hpp>
+#include <learningnet/NodeCosts.hpp>
+#include <learningnet/NodePairCosts.hpp>
 #include <lemon/pairing_heap.h>
+#include <lemon/maps.h>
 #include <algorithm>
 #include <map>
+#include <memory_resource>
 
 namespace learningnet {
 
-//! Representation of costs for each unit node.
-using NodeCosts = std::map<lemon::ListDigraph::Node, double>;
-
-//! Representation of costs for each pair of unit nodes.
-using NodePairCosts = std::map<lemon::ListDigraph::Node, NodeCosts>;
-
 //! Mapping of condition ids (vector indices) to vectors of condition values.
 using ConditionMap = std::vector<std::vector<std::string>>;
 
@@ -23,53 +22,88 @@ using TestMap = std::map<int, int>;
  * Computes active nodes and recommends learning paths (or unit nodes) for a
  * given learning net with accompanying completed sections, condition values and
  * test grades representing a specific learner.
+ *
+ * The learning net is only read, the state of the learner is kept in
+ * LearnerState objects. Hence, many Recommenders can share one learning net.
+ * The states and node lists of learning path searches are allocated from a
+ * memory resource, usually the Arena of the request.
  */
 class Recommender : public Module
 {
 
 private:
-	LearningNet &m_net; //!< learning net
+	const LearningNet &m_net; //!< learning net
+
+	//! memory resource of the states and node lists of searches
+	std::pmr::memory_resource *m_resource;
+
+	//! arrays of the nodes and arcs of #m_net used for traversals
+	std::shared_ptr<const StaticGraph> m_graph;
 
-	const ConditionMap m_conditionVals; //!< condition values of this learner
+	//! grades of the out-arcs of test nodes in #m_graph
+	std::shared_ptr<const GradeTable> m_grades;
+
+	//! branch ids of the condition values of this learner for each condition
+	//! id, containing the else-branch if no value is given
+	const std::vector<std::vector<int>> m_conditionBranches;
+
+	//! branch id of the else-branch for conditions without values
+	const std::vector<int> m_elseBranch;
 
 	const TestMap m_testGrades; //!< test grades of this learner
 
 	//! active nodes as computed in constructor
 	std::vector<lemon::ListDigraph::Node> m_firstActives;
 
-	//! edges visited during first learning path search in constructor
-	lemon::ListDigraph::ArcMap<bool> m_firstVisited;
-
-	//! backup of node types after first learning path search in constructor
-	lemon::ListDigraph::NodeMap<int> m_nodeTypeBackup;
+	//! edges (indexed by arc id) visited during first learning path search in
+	//! constructor
+	std::vector<bool> m_firstVisited;
 
-	//! whether the target was found during the recommendation of a learning path
-	bool m_targetFound;
-
-	//! whether the target was already found after the first learning path
-	//! search in the constructor
-	bool m_targetFoundBackup;
+	//! state of the learner after first learning path search in constructor
+	LearnerState m_firstState;
 
 	/**
-	 * Get sources of #m_net, i.e. nodes with indegree 0.
-	 * Side-effect: The activated in-arcs of each join node are reset.
+	 * Translates the condition values of a learner to branch ids of \p net.
+	 * Values that do not occur in \p net get the id -1, which matches no arc.
 	 *
-	 * @return sources of #m_net
+	 * @param net the learning net
+	 * @param conditionVals mapping of condition ids to vectors of condition
+	 * branches
+	 * @return mapping of condition ids to vectors of branch ids, the branch id
+	 * of the else-branch for condition ids without values
 	 */
-	std::vector<lemon::ListDigraph::Node> getSources()
+	static std::vector<std::vector<int>> toBranchIds(const LearningNet &net,
+			const ConditionMap &conditionVals)
 	{
-		std::vector<lemon::ListDigraph::Node> sources;
-		for (auto v : m_net.nodes()) {
-			if (m_net.isSource(v)) {
-				sources.push_back(v);
+		std::vector<std::vector<int>> conditionBranches;
+		for (auto &vals : conditionVals) {
+			std::vector<int> branches;
+			for (auto &val : vals) {
+				branches.push_back(net.getBranchId(val));
 			}
-
-			if (m_net.isJoin(v)) {
-				m_net.resetActivatedInArcs(v);
+			if (branches.empty()) {
+				branches.push_back(net.getBranchId(CONDITION_ELSE_BRANCH_KEYWORD));
 			}
+			conditionBranches.push_back(branches);
 		}
+		return conditionBranches;
+	}
 
-		return sources;
+	/**
+	 * Get sources of #m_net, i.e. nodes with indegree 0, as precomputed by the
+	 * net.
+	 * Side-effect: The activated in-arcs of each join node are reset in
+	 * \p state.
+	 *
+	 * @param state state of the learner
+	 * @return sources of #m_net
+	 */
+	std::pmr::vector<lemon::ListDigraph::Node> getSources(LearnerState &state) const
+	{
+		state.resetActivatedInArcs();
+		std::vector<lemon::ListDigraph::Node> sources = m_net.getSources();
+		return std::pmr::vector<lemon::ListDigraph::Node>(
+			sources.begin(), sources.end(), m_resource);
 	}
 
 	/**
@@ -78,118 +112,146 @@ private:
 	 * Stop at inactive nodes, collecting them and setting their type to active.
 	 * Return the found new active nodes.
 	 *
+	 * @param state state of the learner, updated during the search
 	 * @param sources list of nodes at which the search for active nodes starts
-	 * @param visited is assigned true for each arc that is visited
+	 * @param visited is assigned true for each arc id that is visited
 	 * (assumes that visited is initialized with false for each arc in #m_net)
 	 * @return newly found active nodes
 	 */
-	std::vector<lemon::ListDigraph::Node> getNewActives(
-		std::vector<lemon::ListDigraph::Node> &sources,
-		lemon::ListDigraph::ArcMap<bool> *visited = nullptr)
+	std::pmr::vector<lemon::ListDigraph::Node> getNewActives(
+		LearnerState &state,
+		std::pmr::vector<lemon::ListDigraph::Node> &sources,
+		std::vector<bool> *visited = nullptr)
 	{
-		std::vector<lemon::ListDigraph::Node> actives;
+		const StaticGraph &graph = *m_graph;
+		std::pmr::vector<lemon::ListDigraph::Node> actives(m_resource);
 		while (!sources.empty()) {
 			lemon::ListDigraph::Node v = sources.back();
 			sources.pop_back();
-			switch (m_net.getType(v)) {
+			switch (state.getType(v)) {
 				case NodeType::inactive:
 					actives.push_back(v);
-					m_net.setType(v, NodeType::active);
+					state.setType(v, NodeType::active);
 					break;
 				case NodeType::active:
 					// TODO remove this?
 					appendError("Input has active units set already. Why?");
 					break;
 				default:
-					if (m_net.isUnknown(v)) {
+					int nodeClass = graph.nodeClass(m_net.id(v));
+					if (nodeClass & NodeClass::unknown) {
 						appendError("Input has nodes of unknown type.");
 						break;
 					}
 
-					// Function to push an arc's target to sources.
-					auto exploreArc = [&](const lemon::ListDigraph::OutArcIt &a) {
+					// Function to push the target of the out-arc with index i
+					// in the static graph to sources.
+					auto exploreArc = [&](int i) {
 						if (visited) {
-							(*visited)[a] = true;
+							(*visited)[graph.arc(i)] = true;
 						}
-						lemon::ListDigraph::Node u = m_net.target(a);
+						int target = graph.target(i);
+						lemon::ListDigraph::Node u = m_net.nodeFromId(target);
+						bool isJoin = graph.hasClass(target, NodeClass::join);
 
 						// Push join nodes only if all necessary in-edges are
 						// activated. All other nodes only have one in-edge and
 						// can be pushed directly when explored.
-						if (m_net.isJoin(u)) {
-							m_net.incrementActivatedInArcs(u);
+						if (isJoin) {
+							state.incrementActivatedInArcs(u);
 						}
 
 						// Once the activated in-arcs of a join reach the number
-						// of its necessary in-arcs, push them. Do not push them
-						// again if the join is visited another time.
-						if (!m_net.isJoin(u) ||
-							m_net.getActivatedInArcs(u) == m_net.getNecessaryInArcs(u)) {
+						// of its necessary in-arcs (its ref value), push them.
+						// Do not push them again if the join is visited another
+						// time.
+						if (!isJoin ||
+							state.getActivatedInArcs(u) == graph.ref(target)) {
 							sources.push_back(u);
 						}
 					};
 
 					if (m_net.isTarget(v)) {
-						m_targetFound = true;
+						state.setTargetReached(true);
 					}
 
-					// For a condition, only explore out-edges corresponding to set user-values.
-					if (m_net.isCondition(v)) {
-						// Get user values for this condition.
-						std::vector<std::string> vals = m_conditionVals[m_net.getConditionId(v)];
-						if (vals.empty()) {
-							vals.push_back(CONDITION_ELSE_BRANCH_KEYWORD);
-						}
+					int outBegin = graph.outBegin(m_net.id(v));
+					int outEnd = graph.outEnd(m_net.id(v));
 
-						for (auto a : m_net.outArcs(v)) {
-							if (std::find(vals.begin(), vals.end(), m_net.getConditionBranch(a)) != vals.end()) {
-								exploreArc(a);
+					// For a condition, only explore out-edges corresponding to set user-values.
+					if (nodeClass & NodeClass::condition) {
+						// Get user values for this condition, the else-branch if
+						// none are given.
+						std::size_t conditionId = graph.ref(m_net.id(v));
+						const std::vector<int> &vals =
+							conditionId < m_conditionBranches.size() ?
+							m_conditionBranches[conditionId] : m_elseBranch;
+
+						for (int i = outBegin; i < outEnd; i++) {
+							if (std::find(vals.begin(), vals.end(), graph.branch(i)) != vals.end()) {
+								exploreArc(i);
 							}
 						}
-					} else if (m_net.isTest(v)) {
+					} else if (nodeClass & NodeClass::test) {
 						// Get the branches with the highest grade that is still
-						// below the actual grade of the user (fittingBranches).
+						// below the actual grade of the user (fitting branches).
 						// Also the branches with the highest grade overall
-						// (highBranches).
+						// (high branches). Branches are sorted by grade, so
+						// both are contiguous ranges of the graded arcs.
+						int testNode = m_net.id(v);
+						if (!m_grades->hasGrades(testNode)) {
+							appendError("Test node with test id " +
+								std::to_string(graph.ref(testNode)) +
+								" has a grade that is no number.");
+							break;
+						}
+						ArrayView<GradedArc> arcs = m_grades->gradedArcs(testNode);
 						auto gradeIt = m_testGrades.find(m_net.getTestId(v));
 						bool hasGrade = gradeIt != m_testGrades.end();
 						int grade = hasGrade ? std::get<1>(*gradeIt) : 0;
 
-						int maxGradeFitting = -1;
+						// Grades below -1 are never explored.
+						int highBegin = m_grades->maxGradeBegin(testNode);
 						int maxGradeOverall = -1;
-						std::vector<lemon::ListDigraph::OutArcIt> fittingBranches;
-						std::vector<lemon::ListDigraph::OutArcIt> highBranches;
-						for (auto a : m_net.outArcs(v)) {
-							int branchGrade = stoi(m_net.getConditionBranch(a));
-							if (hasGrade && grade >= branchGrade) {
-								if (branchGrade > maxGradeFitting) {
-									maxGradeFitting = branchGrade;
-									fittingBranches.clear();
-								}
-								fittingBranches.push_back(a);
-							}
-							if (branchGrade >= maxGradeOverall) {
-								if (branchGrade > maxGradeOverall) {
-									maxGradeOverall = branchGrade;
-									highBranches.clear();
+						if (!arcs.empty() && arcs[highBegin].grade >= -1) {
+							maxGradeOverall = arcs[highBegin].grade;
+						} else {
+							highBegin = arcs.size();
+						}
+
+						int maxGradeFitting = -1;
+						int fittingBegin = 0;
+						int fittingEnd = 0;
+						if (hasGrade) {
+							fittingEnd = std::upper_bound(arcs.begin(), arcs.end(), grade,
+								[](int g, const GradedArc &arc) {
+									return g < arc.grade;
+								}) - arcs.begin();
+							if (fittingEnd > 0 && arcs[fittingEnd - 1].grade >= -1) {
+								maxGradeFitting = arcs[fittingEnd - 1].grade;
+								fittingBegin = fittingEnd - 1;
+								while (fittingBegin > 0 &&
+										arcs[fittingBegin - 1].grade == maxGradeFitting) {
+									fittingBegin--;
 								}
-								highBranches.push_back(a);
+							} else {
+								fittingEnd = 0;
 							}
 						}
 
 						// Explore all collected branches (only once!).
-						for (auto a : fittingBranches) {
-							exploreArc(a);
+						for (int i = fittingBegin; i < fittingEnd; i++) {
+							exploreArc(arcs[i].arc);
 						}
 						if (maxGradeFitting != maxGradeOverall) {
-							for (auto a : highBranches) {
-								exploreArc(a);
+							for (std::size_t i = highBegin; i < arcs.size(); i++) {
+								exploreArc(arcs[i].arc);
 							}
 						}
 					} else {
 						// Else explore all out-edges (for completed units: only one).
-						for (auto a : m_net.outArcs(v)) {
-							exploreArc(a);
+						for (int i = outBegin; i < outEnd; i++) {
+							exploreArc(i);
 						}
 					}
 
@@ -200,18 +262,6 @@ private:
 		return actives;
 	}
 
-	/**
-	 * Reset the state of this Recommender, i.e. set #m_targetFound and types of
-	 * nodes of #m_net to the state they were in after the first call to
-	 * #getNewActives().
-	 */
-	void reset() {
-		for (auto v : m_net.nodes()) {
-			m_net.setType(v, m_nodeTypeBackup[v]);
-		}
-		m_targetFound = m_targetFoundBackup;
-	}
-
 public:
 	/**
 	 * Constructs a Recommender and immediately starts a learning path search
@@ -222,46 +272,79 @@ public:
 	 * one of the first actives and #recPath() returns a learning path starting
 	 * at one of the first actives.
 	 *
-	 * @param net learning net to be used as a basis for recommendation
+	 * @param net learning net to be used as a basis for recommendation, has to
+	 * outlive this Recommender
+	 * @param state state of the learner, i.e. completed unit nodes
 	 * @param conditionVals mapping of condition ids to vectors of condition
 	 * branches (that correspond to properties of the user)
 	 * @param testGrades mapping of test ids to user grades
+	 * @param resource memory resource of the states and node lists of
+	 * searches, has to outlive this Recommender
 	 */
-	Recommender(LearningNet &net,
+	Recommender(const LearningNet &net,
+		const LearnerState &state,
 		const ConditionMap &conditionVals,
-		const TestMap &testGrades)
+		const TestMap &testGrades,
+		std::pmr::memory_resource *resource = std::pmr::get_default_resource())
 	: Module()
 	, m_net{net}
-	, m_conditionVals{conditionVals}
+	, m_resource{resource}
+	, m_graph{net.getStaticGraph()}
+	, m_grades{net.getGradeTable()}
+	, m_conditionBranches{toBranchIds(net, conditionVals)}
+	, m_elseBranch{net.getBranchId(CONDITION_ELSE_BRANCH_KEYWORD)}
 	, m_testGrades{testGrades}
-	, m_firstVisited{net, false}
-	, m_nodeTypeBackup{net}
-	, m_targetFound{false}
-	, m_targetFoundBackup{false}
+	, m_firstVisited(net.maxArcId() + 1, false)
+	, m_firstState{state, resource}
 	{
-		std::vector<lemon::ListDigraph::Node> sources = getSources();
-		m_firstActives = getNewActives(sources, &m_firstVisited);
-
-		// Remember types of nodes after first getNewActives() call.
-		for (auto v : m_net.nodes()) {
-			m_nodeTypeBackup[v] = m_net.getType(v);
-		}
-		m_targetFoundBackup = m_targetFound;
+		m_firstState.setTargetReached(false);
+		std::pmr::vector<lemon::ListDigraph::Node> sources = getSources(m_firstState);
+		std::pmr::vector<lemon::ListDigraph::Node> actives =
+			getNewActives(m_firstState, sources, &m_firstVisited);
+		m_firstActives.assign(actives.begin(), actives.end());
 	}
 
+	/**
+	 * Constructs a Recommender for a learner whose completed unit nodes are
+	 * the ones marked as completed in \p net.
+	 *
+	 * @param net learning net to be used as a basis for recommendation, has to
+	 * outlive this Recommender
+	 * @param conditionVals mapping of condition ids to vectors of condition
+	 * branches (that correspond to properties of the user)
+	 * @param testGrades mapping of test ids to user grades
+	 * @param resource memory resource of the states and node lists of
+	 * searches, has to outlive this Recommender
+	 */
+	Recommender(const LearningNet &net,
+		const ConditionMap &conditionVals,
+		const TestMap &testGrades,
+		std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+	: Recommender(net, LearnerState{net, resource}, conditionVals, testGrades, resource)
+	{}
+
 	/**
 	 * @return a map assigning to each arc whether it was visited during the
 	 * learning path search to find the first active nodes
 	 */
-	lemon::ListDigraph::ArcMap<bool> *getVisited()
+	IdVectorMap<lemon::ListDigraph::Arc, bool> getVisited() const
 	{
-		return &m_firstVisited;
+		return IdVectorMap<lemon::ListDigraph::Arc, bool>{m_firstVisited};
+	}
+
+	/**
+	 * @return state of the learner after the search for the first active
+	 * nodes, i.e. with active nodes set
+	 */
+	const LearnerState &getState() const
+	{
+		return m_firstState;
 	}
 
 	/**
 	 * @return first active nodes as calculated in the constructor
 	 */
-	std::vector<lemon::ListDigraph::Node> recActive()
+	const std::vector<lemon::ListDigraph::Node> &recActive() const
 	{
 		return m_firstActives;
 	}
@@ -279,7 +362,7 @@ public:
 		double minCost = std::numeric_limits<double>::max();
 		std::vector<lemon::ListDigraph::Node>::const_iterator recommended = actives.end();
 		for (auto it = actives.begin(); it != actives.end(); ++it) {
-			double cost = nodeCosts.at(*it);
+			double cost = nodeCosts[*it];
 			if (cost < minCost) {
 				recommended = it;
 				minCost = cost;
@@ -298,34 +381,35 @@ public:
 	}
 
 	/**
+	 * @tparam Nodes vector of nodes
 	 * @param nodePairCosts cost value for each pair of unit nodes
 	 * @param actives active nodes from which the recommended node is chosen
 	 * @param prev previously completed node
 	 * @return pointer to best active node according to \p nodePairCosts
 	 */
-	std::vector<lemon::ListDigraph::Node>::const_iterator recNext(
+	template<typename Nodes>
+	typename Nodes::const_iterator recNext(
 		const NodePairCosts &nodePairCosts,
-		const std::vector<lemon::ListDigraph::Node> &actives,
+		const Nodes &actives,
 		const lemon::ListDigraph::Node &prev = lemon::INVALID)
 	{
-		std::vector<lemon::ListDigraph::Node>::const_iterator recommended = actives.end();
+		typename Nodes::const_iterator recommended = actives.end();
 		double minCost = std::numeric_limits<double>::max();
 		if (prev == lemon::INVALID) {
 			// If there is no previously completed node, use the cost sum over
 			// all node pairs starting at an active node as a guideline.
 			for (auto it = actives.begin(); it != actives.end(); ++it) {
-				double costSumForV = 0.0;
-				for (auto pair : nodePairCosts.at(*it)) {
-					costSumForV += pair.second;
-				}
+				double costSumForV = nodePairCosts.row(*it).sum();
 				if (costSumForV < minCost) {
 					recommended = it;
 					minCost = costSumForV;
 				}
 			}
 		} else {
+			// Scan the costs starting at prev.
+			NodePairCosts::Row prevCosts = nodePairCosts.row(prev);
 			for (auto it = actives.begin(); it != actives.end(); ++it) {
-				double cost = (nodePairCosts.at(prev)).at(*it);
+				double cost = prevCosts[*it];
 				if (cost < minCost) {
 					recommended = it;
 					minCost = cost;
@@ -351,34 +435,34 @@ public:
 	 */
 	std::vector<lemon::ListDigraph::Node> recPath(const NodeCosts &nodeCosts)
 	{
-		using PHeap = lemon::PairingHeap<double, lemon::ListDigraph::NodeMap<int>>;
+		using PHeap = lemon::PairingHeap<double, lemon::RangeMap<int>>;
 		std::vector<lemon::ListDigraph::Node> result;
+		LearnerState state{m_firstState, m_resource};
 
-		// Heap contains currently active nodes, map needed for heap internals.
-		lemon::ListDigraph::NodeMap<int> heapMap(m_net, PHeap::PRE_HEAP);
+		// Heap contains ids of currently active nodes, map needed for heap
+		// internals.
+		lemon::RangeMap<int> heapMap(m_net.maxNodeId() + 1, PHeap::PRE_HEAP);
 		PHeap heap{heapMap};
 
 		for (auto v : m_firstActives) {
-			heap.push(v, nodeCosts.at(v));
+			heap.push(m_net.id(v), nodeCosts[v]);
 		}
 
-		while (!heap.empty() && !m_targetFound) {
-			lemon::ListDigraph::Node bestActive = heap.top();
+		while (!heap.empty() && !state.isTargetReached()) {
+			lemon::ListDigraph::Node bestActive = m_net.nodeFromId(heap.top());
 			heap.pop();
 
-			// Update result and whether target was found.
+			// Update result.
 			result.push_back(bestActive);
-			if (!m_targetFound) {
-				// Search new actives on the basis of the new best active node.
-				m_net.setType(bestActive, NodeType::completed);
-				std::vector<lemon::ListDigraph::Node> newSources = {bestActive};
-				for (auto v : getNewActives(newSources)) {
-					heap.push(v, nodeCosts.at(v));
-				}
+
+			// Search new actives on the basis of the new best active node.
+			state.setType(bestActive, NodeType::completed);
+			std::pmr::vector<lemon::ListDigraph::Node> newSources({bestActive}, m_resource);
+			for (auto v : getNewActives(state, newSources)) {
+				heap.push(m_net.id(v), nodeCosts[v]);
 			}
 		}
 
-		reset();
 		return result;
 	}
 
@@ -392,10 +476,12 @@ public:
 		const lemon::ListDigraph::Node &lastCompleted = lemon::INVALID)
 	{
 		std::vector<lemon::ListDigraph::Node> result;
-		std::vector<lemon::ListDigraph::Node> actives = m_firstActives;
+		std::pmr::vector<lemon::ListDigraph::Node> actives(
+			m_firstActives.begin(), m_firstActives.end(), m_resource);
+		LearnerState state{m_firstState, m_resource};
 
 		lemon::ListDigraph::Node bestActive = lastCompleted;
-		while (!actives.empty() && !m_targetFound) {
+		while (!actives.empty() && !state.isTargetReached()) {
 			auto bestIt = recNext(nodePairCosts, actives, bestActive);
 			if (bestIt == actives.end()) {
 				// This should not happen since !actives.empty() at the
@@ -409,10 +495,10 @@ public:
 			result.push_back(bestActive);
 
 			// Search new actives on the basis of the new best active node.
-			m_net.setType(bestActive, NodeType::completed);
-			std::vector<lemon::ListDigraph::Node> newSources = {bestActive};
-			std::vector<lemon::ListDigraph::Node> newActives =
-				getNewActives(newSources);
+			state.setType(bestActive, NodeType::completed);
+			std::pmr::vector<lemon::ListDigraph::Node> newSources({bestActive}, m_resource);
+			std::pmr::vector<lemon::ListDigraph::Node> newActives =
+				getNewActives(state, newSources);
 
 			// Concat newActives with actives.
 			actives.insert(
@@ -422,7 +508,6 @@ public:
 			);
 		}
 
-		reset();
 		return result;
 	}
 };
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <learningnet/CompiledNet.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Index of the unit nodes of a learning net by their section ids, built once
+ * when a net is loaded.
+ *
+ * Unit nodes are numbered densely in the order of their node ids, this number
+ * is their unit index. A hash map leads from each section id to the unit
+ * indices of its unit nodes (usually exactly one), such that costs and
+ * completed sections given by section id are looked up in constant time.
+ */
+class SectionIndex
+{
+private:
+	//! Unit indices of the unit nodes of one section id in #m_sectionUnits.
+	struct Range {
+		int begin; //!< index of the first unit index
+		int size; //!< number of unit indices
+	};
+
+	std::vector<int> m_unitIndex; //!< unit index of each node id, -1 for others
+
+	std::vector<int> m_node; //!< node id of each unit index
+
+	std::vector<int> m_section; //!< section id of each unit index
+
+	//! unit indices grouped by section id, each group sorted by node id
+	std::vector<int> m_sectionUnits;
+
+	//! range in #m_sectionUnits of each section id
+	std::unordered_map<int, Range> m_ranges;
+
+public:
+	/**
+	 * Creates an index without any unit nodes.
+	 */
+	SectionIndex()
+		: m_unitIndex{}
+		, m_node{}
+		, m_section{}
+		, m_sectionUnits{}
+		, m_ranges{}
+	{}
+
+	/**
+	 * @param nodeCount number of node ids of the net
+	 * @param units pairs of section ids and node ids of all unit nodes, in
+	 * any order
+	 */
+	SectionIndex(int nodeCount, std::vector<std::pair<int, int>> units)
+		: m_unitIndex(nodeCount, -1)
+		, m_node{}
+		, m_section{}
+		, m_sectionUnits{}
+		, m_ranges{}
+	{
+		std::sort(units.begin(), units.end(),
+			[](const std::pair<int, int> &x, const std::pair<int, int> &y) {
+				return x.second < y.second;
+			});
+		for (auto &unit : units) {
+			m_unitIndex[unit.second] = m_node.size();
+			m_node.push_back(unit.second);
+			m_section.push_back(unit.first);
+		}
+
+		for (int i = 0; i < unitCount(); i++) {
+			m_sectionUnits.push_back(i);
+		}
+		std::stable_sort(m_sectionUnits.begin(), m_sectionUnits.end(),
+			[this](int i, int j) { return m_section[i] < m_section[j]; });
+
+		m_ranges.reserve(m_sectionUnits.size());
+		for (int i = 0; i < unitCount(); i++) {
+			int section = m_section[m_sectionUnits[i]];
+			if (i == 0 || m_section[m_sectionUnits[i - 1]] != section) {
+				m_ranges[section] = Range{i, 0};
+			}
+			m_ranges[section].size++;
+		}
+	}
+
+	/**
+	 * Parses a section id as written by std::to_string(), i.e. decimal digits
+	 * without leading zeros, possibly preceded by a minus sign.
+	 *
+	 * @param str the characters
+	 * @param length number of characters of \p str
+	 * @param section is assigned the section id
+	 * @return whether \p str is a section id
+	 */
+	static bool parse(const char *str, std::size_t length, int &section) {
+		std::size_t i = length > 0 && str[0] == '-' ? 1 : 0;
+		if (i == length || (str[i] == '0' && (length > i + 1 || i == 1))) {
+			return false;
+		}
+
+		long long value = 0;
+		for (; i < length; i++) {
+			if (str[i] < '0' || str[i] > '9' || value > (1LL << 32)) {
+				return false;
+			}
+			value = value * 10 + (str[i] - '0');
+		}
+		value = str[0] == '-' ? -value : value;
+		if (value < std::numeric_limits<int>::min() ||
+				value > std::numeric_limits<int>::max()) {
+			return false;
+		}
+		section = value;
+		return true;
+	}
+
+	/**
+	 * @return number of unit nodes
+	 */
+	int unitCount() const {
+		return m_node.size();
+	}
+
+	/**
+	 * @param v node id
+	 * @return unit index of \p v, -1 if \p v is no unit node
+	 */
+	int unitIndex(int v) const {
+		return v >= 0 && static_cast<std::size_t>(v) < m_unitIndex.size() ?
+			m_unitIndex[v] : -1;
+	}
+
+	/**
+	 * @param i unit index
+	 * @return node id of the unit node with index \p i
+	 */
+	int node(int i) const {
+		return m_node[i];
+	}
+
+	/**
+	 * @param i unit index
+	 * @return section id of the unit node with index \p i
+	 */
+	int section(int i) const {
+		return m_section[i];
+	}
+
+	/**
+	 * @param section section id
+	 * @return unit indices of the unit nodes of \p section in the order of
+	 * their node ids, empty if there are none
+	 */
+	ArrayView<int> units(int section) const {
+		auto found = m_ranges.find(section);
+		return found == m_ranges.end() ? ArrayView<int>() :
+			ArrayView<int>(m_sectionUnits.data() + found->second.begin,
+				found->second.size);
+	}
+};
+
+}
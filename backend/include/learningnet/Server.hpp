@@ -0,0 +1,354 @@
+#pragma once
+
+#include <learningnet/Module.hpp>
+#include <learningnet/ThreadPool.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <csignal>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Handles a single request given as a null-terminated JSON string.
+ * Writes the output of the request to the given stream and returns
+ * EXIT_SUCCESS or EXIT_FAILURE.
+ */
+using RequestHandler = std::function<int(char*, std::ostream&)>;
+
+/**
+ * Long-running server answering requests over a Unix domain socket.
+ *
+ * Requests and responses are sent as frames: a 4-byte unsigned length in
+ * network byte order followed by that many bytes of payload.
+ * The payload of a request is the JSON input that would otherwise be passed as
+ * an argument to the executable.
+ * The payload of a response is one byte holding the exit status of the request
+ * (EXIT_SUCCESS or EXIT_FAILURE) followed by the output of the request.
+ *
+ * Each connection may send any number of requests, which are answered in
+ * order. A request longer than #MAX_FRAME_LENGTH is answered with an error
+ * and the connection is closed, as the rest of the request is not read.
+ * If a ThreadPool is given, connections are served concurrently and their
+ * requests are executed by the pool, otherwise connections are served one
+ * after another. The server runs until it receives SIGINT or SIGTERM.
+ */
+class Server : public Module
+{
+private:
+	//! Maximum length of a request payload, longer requests are rejected.
+	static constexpr uint32_t MAX_FRAME_LENGTH = 1u << 30;
+
+	std::string m_socketPath; //!< path of the Unix domain socket
+
+	RequestHandler m_handler; //!< handler called for each request
+
+	int m_listenFd; //!< file descriptor of the listening socket
+
+	ThreadPool *m_pool; //!< pool executing requests if given, else nullptr
+
+	std::set<int> m_connections; //!< open connections served concurrently
+
+	std::mutex m_connectionsMutex; //!< guards #m_connections
+
+	//! notified once a connection served concurrently is closed
+	std::condition_variable m_connectionClosed;
+
+	/**
+	 * @return flag set by the signal handler once the server should stop, an
+	 * atomic since it is read by the threads serving connections
+	 */
+	static std::atomic<bool> &stopRequested() {
+		static std::atomic<bool> stop{false};
+		return stop;
+	}
+
+	/**
+	 * Signal handler for SIGINT and SIGTERM.
+	 */
+	static void onSignal(int) {
+		stopRequested() = true;
+	}
+
+	/**
+	 * Installs #onSignal() for SIGINT and SIGTERM without SA_RESTART such that
+	 * a blocking accept() or read() returns once a signal arrives.
+	 * SIGPIPE is ignored such that closed connections surface as write errors.
+	 */
+	void installSignalHandlers() const {
+		struct sigaction action;
+		std::memset(&action, 0, sizeof(action));
+		action.sa_handler = &Server::onSignal;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGINT, &action, nullptr);
+		sigaction(SIGTERM, &action, nullptr);
+		std::signal(SIGPIPE, SIG_IGN);
+	}
+
+	/**
+	 * Reads exactly \p length bytes from \p fd.
+	 *
+	 * @param fd file descriptor to read from
+	 * @param buf buffer of at least \p length bytes
+	 * @param length number of bytes to read
+	 * @return whether all bytes could be read
+	 */
+	static bool readAll(int fd, char *buf, size_t length) {
+		while (length > 0) {
+			ssize_t n = ::read(fd, buf, length);
+			if (n < 0 && errno == EINTR && !stopRequested()) {
+				continue;
+			}
+			if (n <= 0) {
+				return false;
+			}
+			buf += n;
+			length -= n;
+		}
+		return true;
+	}
+
+	/**
+	 * Writes exactly \p length bytes to \p fd.
+	 *
+	 * @param fd file descriptor to write to
+	 * @param buf buffer of at least \p length bytes
+	 * @param length number of bytes to write
+	 * @return whether all bytes could be written
+	 */
+	static bool writeAll(int fd, const char *buf, size_t length) {
+		while (length > 0) {
+			ssize_t n = ::write(fd, buf, length);
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) {
+				return false;
+			}
+			buf += n;
+			length -= n;
+		}
+		return true;
+	}
+
+	/**
+	 * Reads one request frame from \p fd. A request longer than
+	 * #MAX_FRAME_LENGTH is answered with an error frame, its payload is not
+	 * read.
+	 *
+	 * @param fd file descriptor of the connection
+	 * @param request is assigned the null-terminated payload of the frame
+	 * @return whether a complete frame could be read
+	 */
+	static bool readFrame(int fd, std::vector<char> &request) {
+		uint32_t length;
+		if (!readAll(fd, reinterpret_cast<char*>(&length), sizeof(length))) {
+			return false;
+		}
+		length = ntohl(length);
+		if (length > MAX_FRAME_LENGTH) {
+			writeFrame(fd, EXIT_FAILURE, "Request too large: " +
+				std::to_string(length) + " bytes, at most " +
+				std::to_string(MAX_FRAME_LENGTH) + " bytes are allowed.\n");
+			return false;
+		}
+
+		request.resize(length + 1);
+		request[length] = '\0';
+		return readAll(fd, request.data(), length);
+	}
+
+	/**
+	 * Writes one response frame to \p fd.
+	 *
+	 * @param fd file descriptor of the connection
+	 * @param status exit status of the request
+	 * @param output output of the request
+	 * @return whether the frame could be written completely
+	 */
+	static bool writeFrame(int fd, int status, const std::string &output) {
+		uint32_t length = htonl(static_cast<uint32_t>(output.size() + 1));
+		char statusByte = static_cast<char>(status);
+		return writeAll(fd, reinterpret_cast<const char*>(&length), sizeof(length))
+			&& writeAll(fd, &statusByte, 1)
+			&& writeAll(fd, output.data(), output.size());
+	}
+
+	/**
+	 * Answers all requests sent over the connection \p fd until the client
+	 * closes it. Closing \p fd is left to the caller.
+	 *
+	 * @param fd file descriptor of the connection
+	 */
+	void serveConnection(int fd) {
+		std::vector<char> request;
+		while (!stopRequested() && readFrame(fd, request)) {
+			std::ostringstream out;
+			int status = m_pool ?
+				m_pool->async([&]() { return m_handler(request.data(), out); }).get() :
+				m_handler(request.data(), out);
+			if (!writeFrame(fd, status, out.str())) {
+				break;
+			}
+		}
+	}
+
+	/**
+	 * Serves the connection \p fd in a new detached thread that blocks all
+	 * signals. The connection is registered in #m_connections while it is
+	 * open. It is only closed after being removed from #m_connections, since
+	 * accept() may reuse its descriptor for a new connection right away.
+	 *
+	 * @param fd file descriptor of the connection
+	 */
+	void serveConnectionConcurrently(int fd) {
+		{
+			std::lock_guard<std::mutex> lock{m_connectionsMutex};
+			m_connections.insert(fd);
+		}
+
+		// Signals are only handled by the accepting thread. The signal mask is
+		// inherited by the new thread.
+		sigset_t signals, previous;
+		sigfillset(&signals);
+		pthread_sigmask(SIG_BLOCK, &signals, &previous);
+		std::thread{[this, fd]() {
+			serveConnection(fd);
+			std::lock_guard<std::mutex> lock{m_connectionsMutex};
+			m_connections.erase(fd);
+			::close(fd);
+			m_connectionClosed.notify_all();
+		}}.detach();
+		pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+	}
+
+	/**
+	 * Wakes up all threads blocked on reading a connection such that they
+	 * finish their current request, and waits until they are done.
+	 */
+	void closeConnections() {
+		std::unique_lock<std::mutex> lock{m_connectionsMutex};
+		for (int fd : m_connections) {
+			::shutdown(fd, SHUT_RD);
+		}
+		m_connectionClosed.wait(lock, [this]() { return m_connections.empty(); });
+	}
+
+	/**
+	 * Creates, binds and listens on the socket at #m_socketPath.
+	 * A stale socket file at that path is removed beforehand.
+	 * Fails with an appropriate error message if this is not possible.
+	 */
+	void listen() {
+		struct sockaddr_un addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (m_socketPath.empty() || m_socketPath.size() >= sizeof(addr.sun_path)) {
+			failWithError("Invalid socket path \"" + m_socketPath + "\".");
+			return;
+		}
+		std::strncpy(addr.sun_path, m_socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+		m_listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (m_listenFd < 0) {
+			failWithError("Could not create socket: " +
+				std::string(std::strerror(errno)));
+			return;
+		}
+
+		::unlink(m_socketPath.c_str());
+		if (::bind(m_listenFd, reinterpret_cast<struct sockaddr*>(&addr),
+				sizeof(addr)) < 0 || ::listen(m_listenFd, SOMAXCONN) < 0) {
+			failWithError("Could not listen on socket \"" + m_socketPath +
+				"\": " + std::string(std::strerror(errno)));
+			::close(m_listenFd);
+			m_listenFd = -1;
+		}
+	}
+
+public:
+	/**
+	 * Creates a Server listening on the Unix domain socket \p socketPath.
+	 * Requests are only answered once #run() is called.
+	 *
+	 * @param socketPath path of the Unix domain socket
+	 * @param handler handler called for each request, has to be thread-safe
+	 * if \p pool is given
+	 * @param pool optional pool executing the requests, has to outlive this
+	 * Server
+	 */
+	Server(const std::string &socketPath, const RequestHandler &handler,
+			ThreadPool *pool = nullptr)
+		: Module()
+		, m_socketPath{socketPath}
+		, m_handler{handler}
+		, m_listenFd{-1}
+		, m_pool{pool}
+		, m_connections{}
+		, m_connectionsMutex{}
+		, m_connectionClosed{}
+	{
+		listen();
+	}
+
+	/**
+	 * Closes the listening socket and removes the socket file.
+	 */
+	~Server() {
+		if (m_listenFd >= 0) {
+			::close(m_listenFd);
+			::unlink(m_socketPath.c_str());
+		}
+	}
+
+	Server(const Server&) = delete;
+	Server &operator=(const Server&) = delete;
+
+	/**
+	 * Accepts connections and answers their requests until SIGINT or SIGTERM
+	 * is received. Returns immediately if the socket could not be set up.
+	 * Returns only after all requests in progress are answered.
+	 */
+	void run() {
+		if (!succeeded()) {
+			return;
+		}
+
+		installSignalHandlers();
+		while (!stopRequested()) {
+			int fd = ::accept(m_listenFd, nullptr, nullptr);
+			if (fd < 0) {
+				if (errno != EINTR && errno != ECONNABORTED) {
+					failWithError("Could not accept connection: " +
+						std::string(std::strerror(errno)));
+					break;
+				}
+				continue;
+			}
+
+			if (m_pool) {
+				serveConnectionConcurrently(fd);
+			} else {
+				serveConnection(fd);
+				::close(fd);
+			}
+		}
+
+		closeConnections();
+	}
+};
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Bit-sliced counters of activated in-arcs of join nodes, indexed by node
+ * ids, for 64 learning path searches at once.
+ *
+ * Each search is a lane given by one bit of a uint64_t. The counter of a node
+ * is stored as planes of bits, plane p holding bit p of the counter in every
+ * lane, such that adding 1 in some lanes and comparing with a number of
+ * necessary in-arcs take a few bitwise operations for all lanes together.
+ */
+class SlicedCounters
+{
+public:
+	//! Set of lanes, one bit per lane.
+	using Lanes = uint64_t;
+
+	//! Number of lanes.
+	static constexpr int LANE_COUNT = 64;
+
+private:
+	//! index of the first plane of each node id, followed by the number of
+	//! planes
+	std::vector<int> m_begin;
+
+	std::vector<Lanes> m_planes; //!< planes of all counters
+
+public:
+	/**
+	 * Creates counters without any nodes.
+	 */
+	SlicedCounters()
+		: m_begin{0}
+		, m_planes{}
+	{}
+
+	/**
+	 * Creates counters that are 0 in all lanes.
+	 *
+	 * @param maxCounts largest value of the counter of each node id, e.g. its
+	 * in-degree
+	 */
+	explicit SlicedCounters(const std::vector<int> &maxCounts)
+		: m_begin{}
+		, m_planes{}
+	{
+		m_begin.reserve(maxCounts.size() + 1);
+		int planes = 0;
+		for (int maxCount : maxCounts) {
+			m_begin.push_back(planes);
+			while (maxCount > 0) {
+				planes++;
+				maxCount >>= 1;
+			}
+		}
+		m_begin.push_back(planes);
+		m_planes.assign(planes, 0);
+	}
+
+	/**
+	 * Resets the counters of all nodes to 0 in all lanes.
+	 */
+	void reset() {
+		m_planes.assign(m_planes.size(), 0);
+	}
+
+	/**
+	 * Increments the counter of a node by 1 in some lanes. The counter must
+	 * not exceed the largest value given for the node.
+	 *
+	 * @param v node id
+	 * @param lanes the lanes in which the counter is incremented
+	 */
+	void increment(int v, Lanes lanes) {
+		for (int p = m_begin[v]; p < m_begin[v + 1] && lanes != 0; p++) {
+			Lanes carry = m_planes[p] & lanes;
+			m_planes[p] ^= lanes;
+			lanes = carry;
+		}
+	}
+
+	/**
+	 * @param v node id
+	 * @param k a number
+	 * @return the lanes in which the counter of \p v is at least \p k
+	 */
+	Lanes atLeast(int v, int k) const {
+		int planes = m_begin[v + 1] - m_begin[v];
+		if (planes < 31 && (k >> planes) != 0) {
+			return 0;
+		}
+
+		// Compare from the highest plane, keeping the lanes in which the
+		// higher bits are greater than or equal to the ones of k.
+		Lanes greater = 0;
+		Lanes equal = ~Lanes{0};
+		for (int p = planes - 1; p >= 0; p--) {
+			Lanes plane = m_planes[m_begin[v] + p];
+			if ((k >> p) & 1) {
+				equal &= plane;
+			} else {
+				greater |= equal & plane;
+				equal &= ~plane;
+			}
+		}
+		return greater | equal;
+	}
+
+	/**
+	 * @param v node id
+	 * @param lane index of a lane
+	 * @return the counter of \p v in \p lane
+	 */
+	int get(int v, int lane) const {
+		int count = 0;
+		for (int p = m_begin[v + 1] - 1; p >= m_begin[v]; p--) {
+			count = (count << 1) | int((m_planes[p] >> lane) & 1);
+		}
+		return count;
+	}
+};
+
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <lemon/list_graph.h>
+#include <cstdint>
+#include <vector>
+
+namespace learningnet {
+
+/**
+ * Read-only compressed sparse row representation of a lemon::ListDigraph for
+ * traversals that do not change the graph.
+ *
+ * The out-arcs of all nodes are stored in parallel arrays, the out-arcs of
+ * each node contiguously and in the order in which lemon::ListDigraph::OutArcIt
+ * visits them. Out-arc i leads to the node with id #target(i), is the arc
+ * with id #arc(i) in the ListDigraph and has the branch id #branch(i) if
+ * branch ids were given. Nodes are referred to by their ids in the
+ * ListDigraph as well.
+ *
+ * Everything a traversal reads about a node (where its out-arcs begin, its
+ * in-degree, its ref value and the class of its type) is packed into one
+ * NodeRecord, such that visiting a node touches a single cache line.
+ *
+ * Changes of the ListDigraph are not reflected, a new StaticGraph has to be
+ * built after them.
+ */
+class StaticGraph
+{
+public:
+	//! Record of a node.
+	struct NodeRecord {
+		int32_t outBegin; //!< index of the first out-arc
+		int32_t inDegree; //!< number of in-arcs
+		int32_t ref; //!< ref value, -1 if none was given
+		uint8_t nodeClass; //!< class of the node type, 0 if none was given
+	};
+
+private:
+	//! record of each node id, followed by a record whose out-arcs begin
+	//! after the last out-arc
+	std::vector<NodeRecord> m_nodes;
+
+	std::vector<int> m_target; //!< id of the target node of each out-arc
+
+	std::vector<int> m_arc; //!< arc id of each out-arc
+
+	std::vector<int> m_branch; //!< branch id of each out-arc, or -1
+
+	//! Lemon map assigning the branch id -1 to each arc.
+	struct NoBranches {
+		int operator[](const lemon::ListDigraph::Arc&) const { return -1; }
+	};
+
+	//! Lemon map assigning the class 0 to each node.
+	struct NoClasses {
+		uint8_t operator[](const lemon::ListDigraph::Node&) const { return 0; }
+	};
+
+	//! Lemon map assigning the ref value -1 to each node.
+	struct NoRefs {
+		int operator[](const lemon::ListDigraph::Node&) const { return -1; }
+	};
+
+public:
+	/**
+	 * Creates an empty StaticGraph.
+	 */
+	StaticGraph()
+		: m_nodes{NodeRecord{0, 0, -1, 0}}
+		, m_target{}
+		, m_arc{}
+		, m_branch{}
+	{}
+
+	/**
+	 * Creates a StaticGraph with the nodes and arcs of \p graph, without
+	 * branch ids.
+	 *
+	 * @param graph the graph
+	 */
+	explicit StaticGraph(const lemon::ListDigraph &graph)
+		: StaticGraph(graph, NoBranches{})
+	{}
+
+	/**
+	 * Creates a StaticGraph with the nodes and arcs of \p graph, without
+	 * classes and ref values of the nodes.
+	 *
+	 * @tparam BranchMap lemon map from arcs to int
+	 * @param graph the graph
+	 * @param branches branch id of each arc
+	 */
+	template<typename BranchMap>
+	StaticGraph(const lemon::ListDigraph &graph, const BranchMap &branches)
+		: StaticGraph(graph, branches, NoClasses{}, NoRefs{})
+	{}
+
+	/**
+	 * Creates a StaticGraph with the nodes and arcs of \p graph.
+	 *
+	 * @tparam BranchMap lemon map from arcs to int
+	 * @tparam ClassMap lemon map from nodes to uint8_t
+	 * @tparam RefMap lemon map from nodes to int
+	 * @param graph the graph
+	 * @param branches branch id of each arc
+	 * @param classes class of the type of each node, e.g. a NodeClass
+	 * @param refs ref value of each node
+	 */
+	template<typename BranchMap, typename ClassMap, typename RefMap>
+	StaticGraph(const lemon::ListDigraph &graph,
+			const BranchMap &branches,
+			const ClassMap &classes,
+			const RefMap &refs)
+		: m_nodes(graph.maxNodeId() + 2, NodeRecord{0, 0, -1, 0})
+		, m_target{}
+		, m_arc{}
+		, m_branch{}
+	{
+		m_target.reserve(graph.maxArcId() + 1);
+		m_arc.reserve(graph.maxArcId() + 1);
+		m_branch.reserve(graph.maxArcId() + 1);
+
+		// Nodes are filled in the order of their ids, such that the out-arcs
+		// of node v end where the ones of node v+1 begin.
+		for (int v = 0; v <= graph.maxNodeId(); v++) {
+			m_nodes[v].outBegin = m_arc.size();
+			lemon::ListDigraph::Node node = graph.nodeFromId(v);
+			if (graph.valid(node)) {
+				m_nodes[v].ref = refs[node];
+				m_nodes[v].nodeClass = classes[node];
+				for (lemon::ListDigraph::OutArcIt a(graph, node); a != lemon::INVALID; ++a) {
+					int u = graph.id(graph.target(a));
+					m_target.push_back(u);
+					m_arc.push_back(graph.id(a));
+					m_branch.push_back(branches[a]);
+					m_nodes[u].inDegree++;
+				}
+			}
+		}
+		m_nodes.back().outBegin = m_arc.size();
+	}
+
+	/**
+	 * Creates a StaticGraph from out-arcs given in compressed sparse row form,
+	 * e.g. the ones of a compiled net, without traversing a
+	 * lemon::ListDigraph. Nodes and arcs are referred to by their indices,
+	 * which have to be valid.
+	 *
+	 * @tparam Array random access array of uint32_t, e.g. an ArrayView
+	 * @tparam TargetFunc function taking an arc index and returning the index
+	 * of its target node
+	 * @tparam BranchFunc function taking an arc index and returning its
+	 * branch id
+	 * @tparam ClassFunc function taking a node index and returning the class
+	 * of its type
+	 * @tparam RefFunc function taking a node index and returning its ref value
+	 * @param outArcOffsets offset into \p outArcIds of the first out-arc of
+	 * each node, followed by the number of out-arcs
+	 * @param outArcIds arc indices of the out-arcs grouped by source node
+	 * @param targets target node of each arc
+	 * @param branches branch id of each arc
+	 * @param classes class of the type of each node
+	 * @param refs ref value of each node
+	 */
+	template<typename Array, typename TargetFunc, typename BranchFunc,
+		typename ClassFunc, typename RefFunc>
+	StaticGraph(const Array &outArcOffsets,
+			const Array &outArcIds,
+			const TargetFunc &targets,
+			const BranchFunc &branches,
+			const ClassFunc &classes,
+			const RefFunc &refs)
+		: m_nodes(outArcOffsets.size(), NodeRecord{0, 0, -1, 0})
+		, m_target(outArcIds.size())
+		, m_arc(outArcIds.begin(), outArcIds.end())
+		, m_branch(outArcIds.size())
+	{
+		for (std::size_t v = 0; v + 1 < outArcOffsets.size(); v++) {
+			m_nodes[v].outBegin = outArcOffsets[v];
+			m_nodes[v].ref = refs(v);
+			m_nodes[v].nodeClass = classes(v);
+		}
+		m_nodes.back().outBegin = outArcIds.size();
+
+		for (std::size_t i = 0; i < outArcIds.size(); i++) {
+			int u = targets(outArcIds[i]);
+			m_target[i] = u;
+			m_branch[i] = branches(outArcIds[i]);
+			m_nodes[u].inDegree++;
+		}
+	}
+
+	/**
+	 * @param v node id
+	 * @return index of the first out-arc of \p v
+	 */
+	int outBegin(int v) const {
+		return m_nodes[v].outBegin;
+	}
+
+	/**
+	 * @param v node id
+	 * @return index after the last out-arc of \p v
+	 */
+	int outEnd(int v) const {
+		return m_nodes[v + 1].outBegin;
+	}
+
+	/**
+	 * @param v node id
+	 * @return number of out-arcs of \p v
+	 */
+	int outDegree(int v) const {
+		return m_nodes[v + 1].outBegin - m_nodes[v].outBegin;
+	}
+
+	/**
+	 * @param v node id
+	 * @return number of in-arcs of \p v
+	 */
+	int inDegree(int v) const {
+		return m_nodes[v].inDegree;
+	}
+
+	/**
+	 * @param v node id
+	 * @return ref value of \p v, -1 if none was given
+	 */
+	int ref(int v) const {
+		return m_nodes[v].ref;
+	}
+
+	/**
+	 * @param v node id
+	 * @return class of the type of \p v, 0 if none was given
+	 */
+	uint8_t nodeClass(int v) const {
+		return m_nodes[v].nodeClass;
+	}
+
+	/**
+	 * @param v node id
+	 * @param classes bit flags of classes, e.g. of NodeClass
+	 * @return whether the class of \p v has any of the flags in \p classes
+	 */
+	bool hasClass(int v, uint8_t classes) const {
+		return (m_nodes[v].nodeClass & classes) != 0;
+	}
+
+	/**
+	 * @param i index of an out-arc
+	 * @return id of the target node of out-arc \p i
+	 */
+	int target(int i) const {
+		return m_target[i];
+	}
+
+	/**
+	 * @param i index of an out-arc
+	 * @return arc id of out-arc \p i
+	 */
+	int arc(int i) const {
+		return m_arc[i];
+	}
+
+	/**
+	 * @param i index of an out-arc
+	 * @return branch id of out-arc \p i, -1 if no branch ids were given
+	 */
+	int branch(int i) const {
+		return m_branch[i];
+	}
+};
+
+}
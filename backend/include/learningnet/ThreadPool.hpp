@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+namespace learningnet {
+
+/**
+ * Work-stealing executor for independent jobs such as Recommender or
+ * NetworkChecker runs.
+ *
+ * Each worker thread has its own queue of tasks. Tasks submitted by a worker
+ * are pushed to and taken from the back of its own queue. Idle workers steal
+ * tasks from the front of the queues of other workers. A thread calling
+ * #parallelFor() executes the calls of its own batch that no worker took yet
+ * instead of only waiting, such that #parallelFor() may be nested in tasks
+ * without blocking all workers, while the calling thread never picks up
+ * unrelated tasks, e.g. ones of other requests.
+ *
+ * The worker threads are only started once the first task is submitted, such
+ * that a process that never runs anything in parallel does not spawn them.
+ */
+class ThreadPool
+{
+private:
+	using Task = std::function<void()>;
+
+	//! Queue of tasks of one worker thread.
+	struct Worker {
+		std::deque<Task> tasks; //!< pending tasks of this worker
+		std::mutex mutex; //!< guards #tasks
+	};
+
+	std::vector<std::unique_ptr<Worker>> m_workers; //!< queues of all workers
+
+	std::vector<std::thread> m_threads; //!< the worker threads once started
+
+	std::once_flag m_started; //!< starts #m_threads on the first submission
+
+	std::atomic<bool> m_stop; //!< whether the workers should terminate
+
+	std::atomic<std::size_t> m_pending; //!< number of queued tasks
+
+	std::atomic<std::size_t> m_nextWorker; //!< queue for external submissions
+
+	std::mutex m_sleepMutex; //!< mutex for #m_wake
+
+	std::condition_variable m_wake; //!< wakes idle workers
+
+	/**
+	 * @return index of the worker running the current thread in the pool
+	 * #currentPool(), or -1 if the current thread is no worker
+	 */
+	static int &currentWorker() {
+		static thread_local int worker = -1;
+		return worker;
+	}
+
+	/**
+	 * @return pool of the worker running the current thread, or nullptr
+	 */
+	static const ThreadPool *&currentPool() {
+		static thread_local const ThreadPool *pool = nullptr;
+		return pool;
+	}
+
+	/**
+	 * @return index of the current worker if it belongs to this pool, else -1
+	 */
+	int selfIndex() const {
+		return currentPool() == this ? currentWorker() : -1;
+	}
+
+	/**
+	 * Takes a task from the back of the own queue of the current thread or
+	 * steals one from the front of the queue of another worker.
+	 *
+	 * @param task is assigned the task if one was found
+	 * @return whether a task was found
+	 */
+	bool popTask(Task &task) {
+		int self = selfIndex();
+		if (self >= 0) {
+			Worker &own = *m_workers[self];
+			std::lock_guard<std::mutex> lock{own.mutex};
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				m_pending--;
+				return true;
+			}
+		}
+
+		std::size_t n = m_workers.size();
+		std::size_t start = self >= 0 ? self + 1 : 0;
+		for (std::size_t k = 0; k < n; k++) {
+			Worker &victim = *m_workers[(start + k) % n];
+			std::lock_guard<std::mutex> lock{victim.mutex};
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				m_pending--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Starts the worker threads unless they were started already.
+	 */
+	void start() {
+		std::call_once(m_started, [this]() {
+			for (std::size_t i = 0; i < m_workers.size(); i++) {
+				m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+			}
+		});
+	}
+
+	/**
+	 * Main loop of the worker with index \p index.
+	 * Signals are blocked such that they are only handled by the main thread.
+	 *
+	 * @param index index of the worker
+	 */
+	void workerLoop(int index) {
+		sigset_t signals;
+		sigfillset(&signals);
+		pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+		currentPool() = this;
+		currentWorker() = index;
+
+		Task task;
+		while (true) {
+			if (popTask(task)) {
+				task();
+				task = nullptr;
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock{m_sleepMutex};
+			m_wake.wait(lock, [this]() { return m_stop || m_pending > 0; });
+			if (m_stop && m_pending == 0) {
+				return;
+			}
+		}
+	}
+
+public:
+	/**
+	 * Creates a ThreadPool whose workers are started on the first submission.
+	 *
+	 * @param workers number of worker threads, with 0 all tasks are executed
+	 * by the threads waiting for them
+	 */
+	explicit ThreadPool(unsigned int workers)
+		: m_workers{}
+		, m_threads{}
+		, m_started{}
+		, m_stop{false}
+		, m_pending{0}
+		, m_nextWorker{0}
+	{
+		for (unsigned int i = 0; i < workers; i++) {
+			m_workers.emplace_back(new Worker());
+		}
+	}
+
+	/**
+	 * Finishes all queued tasks and joins the workers.
+	 */
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock{m_sleepMutex};
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (auto &thread : m_threads) {
+			thread.join();
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool &operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @return number of worker threads, whether started or not
+	 */
+	std::size_t size() const {
+		return m_workers.size();
+	}
+
+	/**
+	 * Queues \p task for execution by some worker. If called by a worker of
+	 * this pool, the task is queued at that worker, else the workers are
+	 * chosen round-robin.
+	 *
+	 * @param task the task, must not throw
+	 */
+	void submit(Task task) {
+		if (m_workers.empty()) {
+			task();
+			return;
+		}
+
+		start();
+		int self = selfIndex();
+		std::size_t index = self >= 0 ? self :
+			m_nextWorker++ % m_workers.size();
+		{
+			Worker &worker = *m_workers[index];
+			std::lock_guard<std::mutex> lock{worker.mutex};
+			worker.tasks.push_back(std::move(task));
+			m_pending++;
+		}
+		{
+			// Lock such that no worker misses the notification between
+			// checking #m_pending and going to sleep.
+			std::lock_guard<std::mutex> lock{m_sleepMutex};
+		}
+		m_wake.notify_one();
+	}
+
+	/**
+	 * Executes \p func asynchronously by some worker.
+	 *
+	 * @param func function without arguments
+	 * @return future holding the result or exception of \p func
+	 */
+	template<typename Func>
+	auto async(Func func) -> std::future<decltype(func())> {
+		using Result = decltype(func());
+		auto job = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+		std::future<Result> result = job->get_future();
+		submit([job]() { (*job)(); });
+		return result;
+	}
+
+	/**
+	 * Executes \p func(i) for each i in [0, \p n) in parallel and returns once
+	 * all calls are finished.
+	 *
+	 * The calls form a batch whose indices are claimed one after another by
+	 * the calling thread and by at most one helper task per worker. The
+	 * calling thread claims indices until none are left and then waits only
+	 * for the calls in progress, so it never runs tasks of other batches.
+	 *
+	 * @param n number of calls
+	 * @param func function taking the index of the call
+	 * @throws the exception thrown by the call with the smallest index if any
+	 * call throws
+	 */
+	template<typename Func>
+	void parallelFor(std::size_t n, const Func &func) {
+		if (m_workers.empty() || n <= 1) {
+			for (std::size_t i = 0; i < n; i++) {
+				func(i);
+			}
+			return;
+		}
+
+		// State of the batch, shared with the helper tasks since they may
+		// only be taken from a queue after this call returned. They do not
+		// touch func then, as no index is left to claim.
+		struct Batch {
+			std::atomic<std::size_t> next{0}; //!< next index to claim
+			std::atomic<std::size_t> remaining; //!< calls not finished
+			std::vector<std::exception_ptr> errors; //!< error of each call
+			std::mutex doneMutex; //!< mutex for #done
+			std::condition_variable done; //!< notified after the last call
+
+			explicit Batch(std::size_t n) : remaining{n}, errors(n) {}
+		};
+		auto batch = std::make_shared<Batch>(n);
+
+		// Claims and executes indices of the batch until none are left.
+		auto run = [batch, n, &func]() {
+			for (std::size_t i = batch->next++; i < n; i = batch->next++) {
+				try {
+					func(i);
+				} catch (...) {
+					batch->errors[i] = std::current_exception();
+				}
+				if (--batch->remaining == 0) {
+					std::lock_guard<std::mutex> lock{batch->doneMutex};
+					batch->done.notify_all();
+				}
+			}
+		};
+
+		std::size_t helpers = std::min(n - 1, m_workers.size());
+		for (std::size_t k = 0; k < helpers; k++) {
+			submit(run);
+		}
+		run();
+
+		std::unique_lock<std::mutex> lock{batch->doneMutex};
+		batch->done.wait(lock, [&batch]() { return batch->remaining == 0; });
+		for (auto &error : batch->errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+};
+
+}
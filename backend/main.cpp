@@ -1,23 +1,80 @@
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
+#include <learningnet/Arena.hpp>
 #include <learningnet/NetworkChecker.hpp>
 #include <learningnet/Recommender.hpp>
+#include <learningnet/NetCache.hpp>
+#include <learningnet/NetRegistry.hpp>
+#include <learningnet/Server.hpp>
+#include <learningnet/ThreadPool.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <memory>
 
 using namespace learningnet;
 using namespace rapidjson;
 
+/**
+ * Resources shared by all requests handled by this process.
+ */
+struct RequestContext
+{
+	//! cache of learning nets used for recommendations if given, only
+	//! available when serving many requests
+	NetCache *cache;
+
+	//! nets published by id if given, only available when serving many
+	//! requests
+	NetRegistry *registry;
+
+	//! pool running the independent jobs of batch requests
+	ThreadPool *pool;
+
+	//! directory holding all network files if given, a networkFile then
+	//! names a file in it; if not given, networkFile is any path
+	const std::string *netDir;
+};
+
 class DataReader : public Module
 {
 private:
 	Document m_d; //!< The JSON document to be processed.
 
-	LearningNet *m_net; //!< The learning net read from the document.
+	//! The learning net read from the document for recommendations.
+	std::shared_ptr<const LearningNet> m_net;
+
+	//! Resources shared with other requests if given, else nullptr.
+	const RequestContext *m_context;
+
+	/**
+	 * Called from the constructor after parsing #m_d:
+	 * Checks whether #m_d is a JSON object with an action and initializes the
+	 * data for that action.
+	 */
+	void initialize() {
+		if (m_d.HasParseError() || !m_d.IsObject()) {
+			failWithError("Input is not a valid JSON object.");
+			return;
+		}
+
+		// Only initialize if action given.
+		checkArgs({"action"});
+		if (succeeded()) {
+			initialize(m_d["action"].GetString());
+		}
+	}
 
 	/**
 	 * Called from the constructor:
 	 * Checks whether the correct parameters were set and initializes #m_net if
-	 * the actions "check" or "recommend" were chosen.
+	 * the actions "recommend" or "recommendMany" were chosen.
 	 *
 	 * @param action string given in #m_d under the key "action"
 	 */
@@ -25,10 +82,42 @@ private:
 		// Check for correct parameters.
 		if (action == "check") {
 			checkArgs({"network"});
+		} else if (action == "checkMany") {
+			checkArgs({"networks"});
+			if (succeeded()) {
+				for (auto &network : m_d["networks"].GetArray()) {
+					if (!network.IsString()) {
+						failWithError("Entry of member \"networks\" is not a string.");
+					}
+				}
+			}
 		} else if (action == "create") {
 			checkArgs({"sections"});
+		} else if (action == "compile") {
+			checkArgs({"network","networkFile"});
+		} else if (action == "stats") {
+			// No parameters needed.
+		} else if (action == "publish") {
+			checkArgs({"netId"});
+			checkNetworkSourceArgs();
+		} else if (action == "unpublish") {
+			checkArgs({"netId"});
 		} else if (action == "recommend") {
-			checkArgs({"recType","network","sections","conditions","testGrades"});
+			checkArgs({"recType","sections","conditions","testGrades"});
+			checkNetworkArgs();
+		} else if (action == "recommendMany") {
+			checkArgs({"recType","learners"});
+			checkNetworkArgs();
+			if (succeeded()) {
+				for (auto &learner : m_d["learners"].GetArray()) {
+					if (!learner.IsObject()) {
+						failWithError("Entry of member \"learners\" is not an object.");
+					} else {
+						checkArgs(learner, {"sections","conditions","testGrades"},
+							"Entry of member \"learners\"");
+					}
+				}
+			}
 		} else {
 			failWithError("Given action is unknown.");
 		}
@@ -38,10 +127,7 @@ private:
 			return;
 		}
 
-		if (action == "check") {
-			// Set the net which to check.
-			m_net = new LearningNet(m_d["network"].GetString());
-		} else if (action == "recommend") {
+		if (action == "recommend" || action == "recommendMany") {
 			// Check recType and nodeCosts/nodePairCosts.
 			std::string recType = m_d["recType"].GetString();
 			bool hasActive = recType == "active";
@@ -52,7 +138,7 @@ private:
 			if (!hasActive && !hasNextOrPath) {
 				failWithError("No valid recommendation type "
 					"(\"active\", \"next\" or \"path\") given even "
-					"though the action is \"recommend\".");
+					"though the action is \"" + action + "\".");
 			}
 
 			bool hasNodeCosts = m_d.HasMember("nodeCosts")
@@ -70,13 +156,76 @@ private:
 				checkArgs({"nodePairCosts"});
 			}
 
+			// Check the output format if one is given.
+			if (m_d.HasMember("output")) {
+				checkArgs({"output"});
+				if (succeeded() && getOutput() != "lgf" && getOutput() != "delta") {
+					failWithError("No valid output format (\"lgf\" or "
+						"\"delta\") given.");
+				}
+			}
+
 			// Initialize the net for which to get a recommendation.
-			m_net = new LearningNet(m_d["network"].GetString());
-			std::vector<int> notFound = m_net->setCompleted(getSections());
-			for (auto section : notFound) {
-				appendError("Setting completed units: Could not find section " +
-					std::to_string(section) + ".");
+			// Completed sections are set per learner in a LearnerState, so the
+			// net can be shared with other requests.
+			if (m_d.HasMember("netId")) {
+				initializePublishedNet();
+			} else {
+				m_net = getSharedNet();
 			}
+			if (m_net) {
+				checkTestGrades();
+			}
+		}
+	}
+
+	/**
+	 * Checks whether all test grades of #m_net are numbers, as they are
+	 * compared with the grades of learners.
+	 */
+	void checkTestGrades() {
+		int v = m_net->getGradeTable()->ungradedNode();
+		if (v >= 0) {
+			failWithError("Test node with test id " +
+				std::to_string(m_net->getTestId(m_net->nodeFromId(v))) +
+				" has a grade that is no number.");
+		}
+	}
+
+	/**
+	 * Checks whether either "network" or "networkFile" is given.
+	 */
+	void checkNetworkSourceArgs() {
+		if (m_d.HasMember("networkFile")) {
+			checkArgs({"networkFile"});
+		} else {
+			checkArgs({"network"});
+		}
+	}
+
+	/**
+	 * Checks whether either "network", "networkFile" or "netId" is given, the
+	 * latter only if published nets are available.
+	 */
+	void checkNetworkArgs() {
+		if (!m_d.HasMember("netId")) {
+			checkNetworkSourceArgs();
+		} else if (!m_context || !m_context->registry) {
+			failWithError("Published networks are only available in --serve mode.");
+		} else {
+			checkArgs({"netId"});
+		}
+	}
+
+	/**
+	 * Sets #m_net to the net currently published under the id given in #m_d
+	 * under the key "netId". Later publications do not affect #m_net.
+	 */
+	void initializePublishedNet() {
+		std::string id = getNetId();
+		m_net = m_context->registry->get(id);
+		if (!m_net) {
+			failWithError("No network published under id \"" + id + "\".");
 		}
 	}
 
@@ -89,43 +238,226 @@ private:
 	 * @param args initializer list of key strings to check for
 	 */
 	void checkArgs(const std::initializer_list<const char *> &args)
+	{
+		checkArgs(m_d, args, "Input");
+	}
+
+	/**
+	 * Checks whether the object \p obj has the keys \p args and whether the
+	 * corresponding values have the correct type and content.
+	 *
+	 * If that is not the case, the error is noted via Module::failWithError().
+	 *
+	 * @param obj JSON object to check
+	 * @param args initializer list of key strings to check for
+	 * @param objName name of \p obj used in error messages
+	 */
+	void checkArgs(const Value &obj,
+		const std::initializer_list<const char *> &args,
+		const std::string &objName)
 	{
 		std::map<std::string, std::function<bool(const Value&)>> typeFunc = {
 			{ "action",        std::bind(&Value::IsString, std::placeholders::_1) },
 			{ "network",       std::bind(&Value::IsString, std::placeholders::_1) },
+			{ "netId",         std::bind(&Value::IsString, std::placeholders::_1) },
+			{ "networkFile",   std::bind(&Value::IsString, std::placeholders::_1) },
+			{ "networks",      std::bind(&Value::IsArray, std::placeholders::_1) },
 			{ "recType",       std::bind(&Value::IsString, std::placeholders::_1) },
+			{ "output",        std::bind(&Value::IsString, std::placeholders::_1) },
 			{ "sections",      std::bind(&Value::IsArray, std::placeholders::_1) },
 			{ "conditions",    std::bind(&Value::IsArray, std::placeholders::_1) },
 			{ "testGrades",    std::bind(&Value::IsObject, std::placeholders::_1) },
+			{ "learners",      std::bind(&Value::IsArray, std::placeholders::_1) },
 			{ "nodeCosts",     std::bind(&Value::IsArray, std::placeholders::_1) },
 			{ "nodePairCosts", std::bind(&Value::IsArray, std::placeholders::_1) }
 		};
 
 		for (auto arg : args) {
 			std::string argStr = arg;
-			if (!m_d.HasMember(arg)) {
-				failWithError("Input has no member \"" + argStr + "\".");
+			if (!obj.HasMember(arg)) {
+				failWithError(objName + " has no member \"" + argStr + "\".");
 
-			} else if (!typeFunc[arg](m_d[arg])) {
+			} else if (!typeFunc[arg](obj[arg])) {
 				failWithError("Member \"" + argStr +
 						"\" does not have the correct type.");
 
+			} else if (argStr == "networkFile") {
+				checkNetworkFile(obj[arg].GetString());
+
+			} else if (argStr == "sections") {
+				for (auto &section : obj[arg].GetArray()) {
+					if (!section.IsString()) {
+						failWithError("Entry of member \"sections\" is not a string.");
+						break;
+					}
+				}
+
+			} else if (argStr == "conditions") {
+				for (auto &values : obj[arg].GetArray()) {
+					if (!isStringArray(values)) {
+						failWithError("Entry of member \"conditions\" is not an "
+								"array of strings.");
+						break;
+					}
+				}
+
+			} else if (argStr == "testGrades") {
+				for (auto &grade : obj[arg].GetObject()) {
+					if (!grade.value.IsString()) {
+						failWithError("Grade of test " +
+								std::string(grade.name.GetString()) +
+								" is not a string.");
+						break;
+					}
+				}
+
 			} else if (argStr == "nodeCosts" || argStr == "nodePairCosts") {
-				for (auto &val : m_d[arg].GetArray()) {
-					auto obj = val.GetObject();
-					if (!obj.HasMember("costs")) {
+				for (auto &val : obj[arg].GetArray()) {
+					if (!val.IsObject()) {
+						failWithError("Entry of member \"" + argStr
+								+ "\" is not an object.");
+						break;
+					}
+					auto costObj = val.GetObject();
+					if (argStr == "nodePairCosts" && costObj.HasMember("kernel")) {
+						checkKernel(val);
+					} else if (!costObj.HasMember("costs")) {
 						failWithError("Entry of member \"" + argStr
 								+ "\" has no member \"costs\".");
+					} else if (!checkCosts(costObj["costs"], argStr == "nodePairCosts")) {
+						failWithError("Member \"costs\" of an entry of member \""
+								+ argStr + "\" does not have the correct type.");
 					}
-					if (!obj.HasMember("weight")) {
+					if (!costObj.HasMember("weight")) {
 						failWithError("Entry of member \"" + argStr
 								+ "\" has no member \"weight\".");
+					} else if (!costObj["weight"].IsNumber()) {
+						failWithError("Member \"weight\" of an entry of member \""
+								+ argStr + "\" is no number.");
+					}
+					if (costObj.HasMember("symmetric") &&
+							(argStr != "nodePairCosts" || !costObj["symmetric"].IsBool())) {
+						failWithError("Member \"symmetric\" of an entry of member \""
+								+ argStr + "\" is not allowed or no boolean.");
 					}
 				}
 			}
 		}
 	}
 
+	/**
+	 * Checks whether \p file names a file in the directory of network files
+	 * if one is given, such that clients cannot read or write files anywhere
+	 * else.
+	 *
+	 * @param file the value given under the key "networkFile"
+	 */
+	void checkNetworkFile(const std::string &file) {
+		if (!m_context || !m_context->netDir) {
+			return;
+		}
+		if (m_context->netDir->empty()) {
+			failWithError("Network files are only available in --serve mode "
+				"if --net-dir is given.");
+		} else if (file.empty() || file == "." || file == ".." ||
+				file.find('/') != std::string::npos) {
+			failWithError("Member \"networkFile\" has to be the name of a file "
+				"in the network directory.");
+		}
+	}
+
+	/**
+	 * @param value JSON value
+	 * @return whether \p value is an array whose entries are all strings
+	 */
+	static bool isStringArray(const Value &value)
+	{
+		if (!value.IsArray()) {
+			return false;
+		}
+		for (auto &entry : value.GetArray()) {
+			if (!entry.IsString()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @param costs member "costs" of a cost function
+	 * @param pairs whether the cost function is a node pair cost function
+	 * @return whether \p costs is an object mapping section ids to numbers,
+	 * or for node pair cost functions to objects mapping section ids to
+	 * numbers
+	 */
+	static bool checkCosts(const Value &costs, bool pairs)
+	{
+		if (!costs.IsObject()) {
+			return false;
+		}
+		for (auto &cost : costs.GetObject()) {
+			if (pairs ? !checkCosts(cost.value, false) : !cost.value.IsNumber()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Checks whether a node pair cost function given by a kernel has
+	 * attributes for the sections and valid parameters, fails otherwise.
+	 *
+	 * @param costFunction the node pair cost function
+	 */
+	void checkKernel(const Value &costFunction)
+	{
+		PairCostKernel::Kind kind = PairCostKernel::Kind::absoluteDifference;
+		if (!costFunction["kernel"].IsString() ||
+				!toKernelKind(costFunction["kernel"].GetString(), kind)) {
+			failWithError("No valid kernel (\"absDiff\", \"squaredDiff\" or "
+				"\"threshold\") given for a node pair cost function.");
+		}
+		if (!costFunction.HasMember("attributes") ||
+				!costFunction["attributes"].IsObject()) {
+			failWithError("Node pair cost function with a kernel has no "
+				"object \"attributes\".");
+		} else {
+			auto &attributes = costFunction["attributes"];
+			for (auto itr = attributes.MemberBegin(); itr != attributes.MemberEnd(); ++itr) {
+				if (!itr->value.IsNumber()) {
+					failWithError("Attribute of section " +
+						std::string(itr->name.GetString()) + " is no number.");
+					break;
+				}
+			}
+		}
+		for (const char *param : {"scale", "threshold"}) {
+			if (costFunction.HasMember(param) && !costFunction[param].IsNumber()) {
+				failWithError("Member \"" + std::string(param) +
+					"\" of a node pair cost function is no number.");
+			}
+		}
+	}
+
+	/**
+	 * @param name name of a kernel as given in a node pair cost function
+	 * @param kind is assigned the kernel with name \p name
+	 * @return whether \p name is the name of a kernel
+	 */
+	static bool toKernelKind(const std::string &name, PairCostKernel::Kind &kind)
+	{
+		if (name == "absDiff") {
+			kind = PairCostKernel::Kind::absoluteDifference;
+		} else if (name == "squaredDiff") {
+			kind = PairCostKernel::Kind::squaredDifference;
+		} else if (name == "threshold") {
+			kind = PairCostKernel::Kind::threshold;
+		} else {
+			return false;
+		}
+		return true;
+	}
+
 	/**
 	 * @param oldArr array to convert
 	 * @return vector of ints corresponding to \p oldArr
@@ -184,32 +516,57 @@ private:
 	}
 
 	/**
-	 * @param nodeCostArr array of weights & cost function values for each node
-	 * @return weighted sum of all costs given for each node
+	 * @param units the unit nodes of #m_net by section id
+	 * @param section section id as used as key in cost dictionaries
+	 * @return unit indices of the unit nodes of \p section, empty if \p section
+	 * is no section id of a unit node
 	 */
-	NodeCosts toNodeCosts(const Value &nodeCostArr) const
+	static ArrayView<int> getUnits(const SectionIndex &units, const Value &section)
 	{
-		NodeCosts nodeCosts;
+		int id;
+		return SectionIndex::parse(section.GetString(), section.GetStringLength(), id) ?
+			units.units(id) : ArrayView<int>();
+	}
 
-		// Get weight sum.
+	/**
+	 * @param costArrs arrays of weights & cost function values
+	 * @return sum of the weights of all cost functions in \p costArrs
+	 */
+	double getWeightSum(std::initializer_list<const Value*> costArrs) const
+	{
 		double weightSum = 0.0;
-		for (auto &val : nodeCostArr.GetArray()) {
-			weightSum += val.GetObject()["weight"].GetDouble();
+		for (const Value *costArr : costArrs) {
+			for (auto &val : costArr->GetArray()) {
+				weightSum += val.GetObject()["weight"].GetDouble();
+			}
 		}
+		return weightSum;
+	}
 
+	/**
+	 * @param nodeCostArr array of weights & cost function values for each node
+	 * @param weightSum sum of the weights of all cost functions
+	 * @return weighted sum of the costs given in \p nodeCostArr for each unit
+	 * node, the costs are added up in the order of the cost functions
+	 */
+	NodeCosts toNodeCosts(const Value &nodeCostArr, double weightSum) const
+	{
+		NodeCosts nodeCosts{*m_net};
 		for (auto v : m_net->nodes()) {
 			if (m_net->isUnit(v)) {
-				const char *vSection =
-					std::to_string(m_net->getSection(v)).c_str();
 				nodeCosts[v] = 0.0;
+			}
+		}
 
-				for (auto &val : nodeCostArr.GetArray()) {
-					double weight = val.GetObject()["weight"].GetDouble();
-					auto &costDict = val.GetObject()["costs"];
-					auto itr = costDict.FindMember(vSection);
-					if (itr != costDict.MemberEnd()) {
-						nodeCosts[v] += (itr->value.GetDouble() * weight) / weightSum;
-					}
+		std::shared_ptr<const SectionIndex> index = m_net->getSectionIndex();
+		const SectionIndex &units = *index;
+		for (auto &val : nodeCostArr.GetArray()) {
+			double weight = val.GetObject()["weight"].GetDouble();
+			auto &costDict = val.GetObject()["costs"];
+			for (auto itr = costDict.MemberBegin(); itr != costDict.MemberEnd(); ++itr) {
+				for (int i : getUnits(units, itr->name)) {
+					nodeCosts[m_net->nodeFromId(units.node(i))] +=
+						(itr->value.GetDouble() * weight) / weightSum;
 				}
 			}
 		}
@@ -218,6 +575,138 @@ private:
 	}
 
 	/**
+	 * @param nodeCostArr array of weights & cost function values for each node
+	 * @return weighted sum of all costs given for each node
+	 */
+	NodeCosts toNodeCosts(const Value &nodeCostArr) const
+	{
+		return toNodeCosts(nodeCostArr, getWeightSum({&nodeCostArr}));
+	}
+
+	/**
+	 * @param costFunction weight & cost function values for each pair of nodes
+	 * @return whether the cost function is declared symmetric, i.e. each pair
+	 * costs as much as the reversed pair and only one of both is given
+	 */
+	static bool isSymmetric(const Value &costFunction)
+	{
+		return costFunction.HasMember("symmetric")
+			&& costFunction["symmetric"].GetBool();
+	}
+
+	/**
+	 * Calls \p f for each cost of a pair of unit nodes given in \p
+	 * costFunction.
+	 *
+	 * @tparam Function function taking two unit nodes and the cost of the pair
+	 * @param costFunction weight & cost function values for each pair of nodes
+	 * @param units the unit nodes of #m_net by section id
+	 * @param f the function
+	 */
+	template<typename Function>
+	void forEachPairCost(const Value &costFunction,
+		const SectionIndex &units,
+		Function f) const
+	{
+		auto &costDict = costFunction["costs"];
+		for (auto itr = costDict.MemberBegin(); itr != costDict.MemberEnd(); ++itr) {
+			ArrayView<int> srcs = getUnits(units, itr->name);
+			if (srcs.empty()) {
+				continue;
+			}
+			for (auto itr2 = itr->value.MemberBegin();
+					itr2 != itr->value.MemberEnd(); ++itr2) {
+				ArrayView<int> tgts = getUnits(units, itr2->name);
+				for (int i : srcs) {
+					for (int j : tgts) {
+						if (i != j) {
+							f(m_net->nodeFromId(units.node(i)),
+								m_net->nodeFromId(units.node(j)),
+								itr2->value.GetDouble());
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * Checks whether the weighted sums of the costs given in \p costFunctions
+	 * can be stored as integer codes: This is the case if every cost is a
+	 * non-negative integer and every weight an integer multiple of the lowest
+	 * positive weight.
+	 *
+	 * @param costFunctions weights & cost function values for each node or
+	 * each pair of nodes
+	 * @param quantum is assigned the lowest positive weight
+	 * @param maxCode is assigned an upper bound of the weighted sums of costs
+	 * divided by \p quantum
+	 * @return whether the weighted sums of costs can be stored as codes of at
+	 * most 16 bits
+	 */
+	bool getQuantization(const std::vector<const Value*> &costFunctions,
+		double &quantum,
+		uint32_t &maxCode) const
+	{
+		// Highest cost in a dictionary of costs or of dictionaries of costs.
+		std::function<bool(const Value&, double&)> maxCost =
+			[&maxCost](const Value &costs, double &max) {
+				for (auto itr = costs.MemberBegin(); itr != costs.MemberEnd(); ++itr) {
+					if (itr->value.IsObject()) {
+						if (!maxCost(itr->value, max)) {
+							return false;
+						}
+						continue;
+					}
+					double cost = itr->value.GetDouble();
+					if (cost < 0.0 || cost > UINT16_MAX || cost != std::floor(cost)) {
+						return false;
+					}
+					max = std::max(max, cost);
+				}
+				return true;
+			};
+
+		quantum = 0.0;
+		for (const Value *costFunction : costFunctions) {
+			double weight = (*costFunction)["weight"].GetDouble();
+			if (weight < 0.0) {
+				return false;
+			}
+			if (weight > 0.0 && (quantum == 0.0 || weight < quantum)) {
+				quantum = weight;
+			}
+		}
+		if (quantum == 0.0) {
+			return false;
+		}
+
+		uint64_t codeSum = 0;
+		for (const Value *costFunction : costFunctions) {
+			double weight = (*costFunction)["weight"].GetDouble();
+			double multiple = weight / quantum;
+			double max = 0.0;
+			if (multiple != std::floor(multiple) || multiple > UINT16_MAX ||
+					multiple * quantum != weight ||
+					!maxCost((*costFunction)["costs"], max)) {
+				return false;
+			}
+			codeSum += static_cast<uint64_t>(multiple) * static_cast<uint64_t>(max);
+		}
+		maxCode = static_cast<uint32_t>(std::min<uint64_t>(codeSum, UINT32_MAX));
+		return codeSum <= UINT16_MAX;
+	}
+
+	/**
+	 * The cost of a pair of unit nodes is the weighted sum of the node costs
+	 * of its second node and its own costs. If no node costs are given and
+	 * only few pairs have costs, the costs are stored in sparse rows. Else if
+	 * all costs are integers, they are stored as 8 or 16 bit codes, see
+	 * #getQuantization(). The costs of symmetric cost functions (see
+	 * #isSymmetric()) are kept apart for each unordered pair, cost functions
+	 * given by a kernel (see PairCostKernel) are only computed when needed.
+	 *
+	 * @param nodeCostArr array of weights & cost function values for each node
 	 * @param nodePairCostArr array of weights & cost function values for each
 	 * pair of nodes
 	 * @return weighted sum of all costs given for each pair of nodes
@@ -226,56 +715,169 @@ private:
 		const Value &nodeCostArr,
 		const Value &nodePairCostArr) const
 	{
-		NodePairCosts nodePairCosts;
+		double weightSum = getWeightSum({&nodeCostArr, &nodePairCostArr});
+		std::shared_ptr<const SectionIndex> index = m_net->getSectionIndex();
+		const SectionIndex &units = *index;
 
-		// Get weight sum.
-		double weightSum = 0.0;
+		// Lists needed only while aggregating the costs are freed at once.
+		Arena arena;
+		std::pmr::vector<lemon::ListDigraph::Node> allUnits(arena.resource());
+		allUnits.reserve(units.unitCount());
+		for (int i = 0; i < units.unitCount(); i++) {
+			allUnits.push_back(m_net->nodeFromId(units.node(i)));
+		}
+
+		bool hasNodeCosts = false;
+		std::vector<const Value*> costFunctions;
 		for (auto &val : nodeCostArr.GetArray()) {
-			weightSum += val.GetObject()["weight"].GetDouble();
+			hasNodeCosts = hasNodeCosts || val.GetObject()["costs"].MemberCount() > 0;
+			costFunctions.push_back(&val);
 		}
+		std::vector<const Value*> pairCostFunctions;
+		std::vector<const Value*> symmetricCostFunctions;
+		std::vector<const Value*> kernelCostFunctions;
 		for (auto &val : nodePairCostArr.GetArray()) {
-			weightSum += val.GetObject()["weight"].GetDouble();
+			if (val.HasMember("kernel")) {
+				kernelCostFunctions.push_back(&val);
+			} else if (isSymmetric(val)) {
+				symmetricCostFunctions.push_back(&val);
+			} else {
+				pairCostFunctions.push_back(&val);
+			}
 		}
+		costFunctions.insert(costFunctions.end(),
+			pairCostFunctions.begin(), pairCostFunctions.end());
 
-		// Get weighted costs for each node pair.
-		for (auto &v : m_net->nodes()) {
-			if (m_net->isUnit(v)) {
-				const char *srcSection =
-					std::to_string(m_net->getSection(v)).c_str();
-
-				for (auto &w : m_net->nodes()) {
-					if (m_net->isUnit(w) && v != w) {
-						const char *tgtSection =
-							std::to_string(m_net->getSection(w)).c_str();
-						nodePairCosts[v][w] = 0.0;
-
-						for (auto &val : nodeCostArr.GetArray()) {
-							auto obj = val.GetObject();
-							double weight = obj["weight"].GetDouble();
-							auto &costDict = obj["costs"];
-							auto itr = costDict.FindMember(tgtSection);
-							if (itr != costDict.MemberEnd()) {
-								nodePairCosts[v][w] +=
-									(itr->value.GetDouble() * weight) / weightSum;
-							}
-						}
+		NodePairCosts nodePairCosts = toAsymmetricCosts(nodeCostArr,
+			pairCostFunctions, costFunctions, hasNodeCosts, weightSum, units, allUnits);
 
-						for (auto &val : nodePairCostArr.GetArray()) {
-							auto obj = val.GetObject();
-							double weight = obj["weight"].GetDouble();
-							auto &costDict = obj["costs"];
-							auto itr = costDict.FindMember(srcSection);
-							if (itr != costDict.MemberEnd()) {
-								auto itr2 = itr->value.FindMember(tgtSection);
-								if (itr2 != itr->value.MemberEnd()) {
-									nodePairCosts[v][w] +=
-										(itr2->value.GetDouble() * weight) / weightSum;
-								}
+		// Costs of symmetric cost functions are added once per unordered pair,
+		// even if both orders are given.
+		std::pmr::vector<bool> given(arena.resource());
+		for (const Value *costFunction : symmetricCostFunctions) {
+			double weight = (*costFunction)["weight"].GetDouble();
+			given.assign(allUnits.size() * allUnits.size(), false);
+			forEachPairCost(*costFunction, units,
+				[&](lemon::ListDigraph::Node v, lemon::ListDigraph::Node w, double cost) {
+					int i = nodePairCosts.unitIndex(v);
+					int j = nodePairCosts.unitIndex(w);
+					std::size_t pair = std::min(i, j) * allUnits.size() + std::max(i, j);
+					if (!given[pair]) {
+						given[pair] = true;
+						nodePairCosts.addSymmetric(v, w, (cost * weight) / weightSum);
+					}
+				});
+		}
+
+		// Costs of kernels are computed from the attributes when needed.
+		for (const Value *costFunction : kernelCostFunctions) {
+			const Value &kernel = *costFunction;
+			// The name of the kernel was validated by checkKernel().
+			PairCostKernel::Kind kind = PairCostKernel::Kind::absoluteDifference;
+			toKernelKind(kernel["kernel"].GetString(), kind);
+			std::vector<double> attributes(nodePairCosts.unitCount(),
+				std::numeric_limits<double>::quiet_NaN());
+			auto &attributeDict = kernel["attributes"];
+			for (auto itr = attributeDict.MemberBegin();
+					itr != attributeDict.MemberEnd(); ++itr) {
+				for (int i : getUnits(units, itr->name)) {
+					attributes[i] = itr->value.GetDouble();
+				}
+			}
+			nodePairCosts.addKernel(PairCostKernel(kind,
+				kernel.HasMember("scale") ? kernel["scale"].GetDouble() : 1.0,
+				kernel.HasMember("threshold") ? kernel["threshold"].GetDouble() : 0.0,
+				kernel["weight"].GetDouble(), weightSum, std::move(attributes)));
+		}
+
+		return nodePairCosts;
+	}
+
+	/**
+	 * @param nodeCostArr array of weights & cost function values for each node
+	 * @param pairCostFunctions weights & cost function values for each pair of
+	 * nodes that are not symmetric
+	 * @param costFunctions all functions of \p nodeCostArr followed by \p
+	 * pairCostFunctions
+	 * @param hasNodeCosts whether any node costs are given
+	 * @param weightSum sum of the weights of all cost functions
+	 * @param units the unit nodes of #m_net by section id
+	 * @param allUnits all unit nodes in the order of their unit indices
+	 * @return weighted sum of the node costs of the second node and the costs
+	 * of the given pair cost functions for each pair of nodes
+	 */
+	NodePairCosts toAsymmetricCosts(
+		const Value &nodeCostArr,
+		const std::vector<const Value*> &pairCostFunctions,
+		const std::vector<const Value*> &costFunctions,
+		bool hasNodeCosts,
+		double weightSum,
+		const SectionIndex &units,
+		const std::pmr::vector<lemon::ListDigraph::Node> &allUnits) const
+	{
+		// Without node costs, every pair without own costs costs 0.
+		if (!hasNodeCosts) {
+			std::vector<std::tuple<lemon::ListDigraph::Node,
+				lemon::ListDigraph::Node, double>> entries;
+			for (const Value *costFunction : pairCostFunctions) {
+				double weight = (*costFunction)["weight"].GetDouble();
+				forEachPairCost(*costFunction, units,
+					[&](lemon::ListDigraph::Node v, lemon::ListDigraph::Node w, double cost) {
+						entries.emplace_back(v, w, (cost * weight) / weightSum);
+					});
+			}
+			if (entries.size() < allUnits.size() * allUnits.size() / 2) {
+				return NodePairCosts::sparse(*m_net, entries);
+			}
+		}
+
+		double quantum;
+		uint32_t maxCode;
+		if (getQuantization(costFunctions, quantum, maxCode)) {
+			NodePairCosts nodePairCosts =
+				NodePairCosts::quantized(*m_net, maxCode, quantum, weightSum);
+			for (auto &val : nodeCostArr.GetArray()) {
+				auto obj = val.GetObject();
+				uint32_t multiple = obj["weight"].GetDouble() / quantum;
+				auto &costDict = obj["costs"];
+				for (auto itr = costDict.MemberBegin(); itr != costDict.MemberEnd(); ++itr) {
+					uint32_t code = multiple * static_cast<uint32_t>(itr->value.GetDouble());
+					for (int j : getUnits(units, itr->name)) {
+						lemon::ListDigraph::Node w = m_net->nodeFromId(units.node(j));
+						for (auto v : allUnits) {
+							if (v != w) {
+								nodePairCosts.addCode(v, w, code);
 							}
 						}
 					}
 				}
 			}
+			for (const Value *costFunction : pairCostFunctions) {
+				uint32_t multiple = (*costFunction)["weight"].GetDouble() / quantum;
+				forEachPairCost(*costFunction, units,
+					[&](lemon::ListDigraph::Node v, lemon::ListDigraph::Node w, double cost) {
+						nodePairCosts.addCode(v, w, multiple * static_cast<uint32_t>(cost));
+					});
+			}
+			return nodePairCosts;
+		}
+
+		// Otherwise, each pair starts with the node costs of its second node.
+		NodeCosts nodeCosts = toNodeCosts(nodeCostArr, weightSum);
+		NodePairCosts nodePairCosts{*m_net};
+		for (auto v : allUnits) {
+			for (auto w : allUnits) {
+				if (v != w) {
+					nodePairCosts.add(v, w, nodeCosts[w]);
+				}
+			}
+		}
+		for (const Value *costFunction : pairCostFunctions) {
+			double weight = (*costFunction)["weight"].GetDouble();
+			forEachPairCost(*costFunction, units,
+				[&](lemon::ListDigraph::Node v, lemon::ListDigraph::Node w, double cost) {
+					nodePairCosts.add(v, w, (cost * weight) / weightSum);
+				});
 		}
 
 		return nodePairCosts;
@@ -284,31 +886,116 @@ private:
 public:
 
 	/**
-	 * Reads the data \p data, initializes an underlying JSON Document #m_d and
-	 * checks whether the correct keys and values were given.
-	 * If the actions "check" or "recommend" were chosen, #m_net is also set.
+	 * Reads the data \p data in place, initializes an underlying JSON Document
+	 * #m_d and checks whether the correct keys and values were given.
+	 * If the actions "recommend" or "recommendMany" were chosen, #m_net is
+	 * also set.
 	 *
-	 * @param data JSON data to read
+	 * Strings of #m_d point into \p data, so \p data is modified and must
+	 * outlive this DataReader.
+	 *
+	 * @param data null-terminated JSON data to read
+	 * @param context optional resources shared with other requests, #m_net is
+	 * taken from their cache or registry
 	 */
-	DataReader(char *data) {
-		// Parse document.
-		m_d.Parse(data);
+	DataReader(char *data, const RequestContext *context = nullptr)
+		: m_net{nullptr}
+		, m_context{context}
+	{
+		m_d.ParseInsitu(data);
+		initialize();
+	}
 
-		// Only initialize if action given.
-		checkArgs({"action"});
-		if (succeeded()) {
-			initialize(m_d["action"].GetString());
-		}
+	/**
+	 * Reads the read-only data \p data, initializes an underlying JSON Document
+	 * #m_d and checks whether the correct keys and values were given.
+	 * If the actions "recommend" or "recommendMany" were chosen, #m_net is
+	 * also set.
+	 *
+	 * @param data JSON data to read
+	 * @param length number of characters in \p data
+	 * @param context optional resources shared with other requests, #m_net is
+	 * taken from their cache or registry
+	 */
+	DataReader(const char *data, std::size_t length, const RequestContext *context = nullptr)
+		: m_net{nullptr}
+		, m_context{context}
+	{
+		m_d.Parse(data, length);
+		initialize();
 	}
 
 	std::string getAction() const {
 		return m_d["action"].GetString();
 	}
 
-	LearningNet *getNet() const {
+	std::shared_ptr<const LearningNet> getNet() const {
 		return m_net;
 	}
 
+	std::string getNetId() const {
+		return m_d["netId"].GetString();
+	}
+
+	/**
+	 * @return path of the file given in #m_d under the key "networkFile",
+	 * inside the directory of network files if one is given
+	 */
+	std::string getNetworkFile() const {
+		std::string file = m_d["networkFile"].GetString();
+		if (m_context && m_context->netDir) {
+			return *m_context->netDir + "/" + file;
+		}
+		return file;
+	}
+
+	/**
+	 * @return LearningNet read from the value given in #m_d under the key
+	 * "network" or from the memory-mapped file given under "networkFile",
+	 * taken from the cache of #m_context if available
+	 */
+	std::shared_ptr<const LearningNet> getSharedNet() const {
+		std::unique_ptr<MappedFile> file;
+		const char *network;
+		std::size_t length;
+		if (m_d.HasMember("networkFile")) {
+			file.reset(new MappedFile(getNetworkFile()));
+			network = file->data();
+			length = file->size();
+		} else {
+			network = m_d["network"].GetString();
+			length = m_d["network"].GetStringLength();
+		}
+
+		if (m_context && m_context->cache) {
+			return m_context->cache->get(network, length);
+		}
+		return std::make_shared<const LearningNet>(network, length);
+	}
+
+	/**
+	 * @return new LearningNet read from the value given in #m_d under the key
+	 * "network"
+	 */
+	LearningNet *readNet() const {
+		const Value &network = m_d["network"];
+		return new LearningNet(network.GetString(), network.GetStringLength());
+	}
+
+	SizeType getNetworkCount() const {
+		return m_d["networks"].Size();
+	}
+
+	/**
+	 * @param i index of the network
+	 * @return new LearningNet read from the \p i-th value given in #m_d under
+	 * the key "networks"
+	 */
+	LearningNet *readNet(SizeType i) const {
+		const Value &network = m_d["networks"][i];
+		return new LearningNet(network.GetString(), network.GetStringLength());
+	}
+
 	std::vector<int> getSections() const {
 		return toIntVector(m_d["sections"]);
 	}
@@ -317,6 +1004,14 @@ public:
 		return m_d["recType"].GetString();
 	}
 
+	/**
+	 * @return the output format given in #m_d under the key "output", "lgf" if
+	 * none is given
+	 */
+	std::string getOutput() const {
+		return m_d.HasMember("output") ? m_d["output"].GetString() : "lgf";
+	}
+
 	ConditionMap getConditionValues() const {
 		return toConditionMap(m_d["conditions"]);
 	}
@@ -325,6 +1020,22 @@ public:
 		return toTestMap(m_d["testGrades"]);
 	}
 
+	SizeType getLearnerCount() const {
+		return m_d["learners"].Size();
+	}
+
+	std::vector<int> getSections(SizeType learner) const {
+		return toIntVector(m_d["learners"][learner]["sections"]);
+	}
+
+	ConditionMap getConditionValues(SizeType learner) const {
+		return toConditionMap(m_d["learners"][learner]["conditions"]);
+	}
+
+	TestMap getTestGrades(SizeType learner) const {
+		return toTestMap(m_d["learners"][learner]["testGrades"]);
+	}
+
 	NodeCosts getNodeCosts() const {
 		return toNodeCosts(m_d["nodeCosts"]);
 	}
@@ -340,70 +1051,556 @@ public:
 };
 
 
-int main(int argc, char *argv[])
+/**
+ * Aggregates the costs given in \p reader, either only node costs or node pair
+ * costs that include the node costs.
+ *
+ * @param reader DataReader for a recommendation with next or path recType
+ * @param nodeCosts is assigned the node costs if only those are given
+ * @param nodePairCosts is assigned the node pair costs otherwise
+ */
+void readCosts(const DataReader &reader,
+	std::unique_ptr<NodeCosts> &nodeCosts,
+	std::unique_ptr<NodePairCosts> &nodePairCosts)
 {
-	if (argc < 2) {
-		std::cout << "No argument given to executable." << std::endl;
-		return EXIT_FAILURE;
+	if (reader.hasOnlyNodeCosts()) {
+		nodeCosts.reset(new NodeCosts(reader.getNodeCosts()));
+	} else {
+		nodePairCosts.reset(new NodePairCosts(reader.getNodePairCosts()));
+	}
+}
+
+/**
+ * Passes \p net and the state of a learner to a Recommender, which sets the
+ * appropriate unit nodes as active, and writes the net with the node types of
+ * the learner and recommendation to \p out, or only the active nodes,
+ * recommendation and visited arcs if \p delta is true.
+ * Active nodes are set for every recommendation type. The net itself is not
+ * changed.
+ *
+ * @param net learning net
+ * @param sections completed sections of the learner
+ * @param recType "active", "next" or "path"
+ * @param conditionVals condition values of the learner
+ * @param testGrades test grades of the learner
+ * @param nodeCosts node costs for "next" and "path" if given, else nullptr
+ * @param nodePairCosts node pair costs for "next" and "path" if no node costs
+ * are given, else nullptr
+ * @param delta whether to write the output as a JSON delta instead of LGF
+ * @param out the stream to which the output or error message is written
+ * @param resource memory resource of the states of the learner, e.g. of the
+ * Arena of the request
+ * @return EXIT_FAILURE if the Recommender failed, EXIT_SUCCESS otherwise
+ */
+int recommend(const LearningNet &net,
+	const std::vector<int> &sections,
+	const std::string &recType,
+	const ConditionMap &conditionVals,
+	const TestMap &testGrades,
+	const NodeCosts *nodeCosts,
+	const NodePairCosts *nodePairCosts,
+	bool delta,
+	std::ostream &out,
+	std::pmr::memory_resource *resource)
+{
+	LearnerState learner(net, resource);
+	learner.setCompleted(sections);
+	Recommender rec(net, learner, conditionVals, testGrades, resource);
+	LearnerState state{rec.getState(), resource};
+
+	if (recType == "path") {
+		// Set path with heuristically lowest costs as path attribute.
+		std::vector<lemon::ListDigraph::Node> recPath = nodeCosts ?
+			rec.recPath(*nodeCosts) :
+			rec.recPath(*nodePairCosts);
+
+		state.setRecommended(recPath);
+	} else if (recType == "next") {
+		// Set node with lowest costs as recommended path attribute.
+		std::vector<lemon::ListDigraph::Node>::const_iterator recIt = nodeCosts ?
+			rec.recNext(*nodeCosts) :
+			rec.recNext(*nodePairCosts);
+
+		std::vector<lemon::ListDigraph::Node> recPath;
+		if (recIt != rec.recActive().end()) {
+			recPath.push_back(*recIt);
+		}
+		state.setRecommended(recPath);
+	}
+
+	auto visited = rec.getVisited();
+	if (delta) {
+		state.writeDelta(out, &visited);
+	} else {
+		state.write(out, &visited);
+	}
+	return rec.handleFailure(out);
+}
+
+/**
+ * Writes the result of one request of a batch as a JSON object on its own
+ * line, with the same keys as used by the PHP interface.
+ *
+ * @param out the stream to which the result is written
+ * @param status EXIT_SUCCESS or EXIT_FAILURE
+ * @param message output or error message of the request
+ */
+void writeResult(std::ostream &out, int status, const std::string &message)
+{
+	StringBuffer buffer;
+	Writer<StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("succeeded");
+	writer.Bool(status == EXIT_SUCCESS);
+	writer.Key("message");
+	writer.String(message.c_str(), message.size());
+	writer.EndObject();
+	out << buffer.GetString() << std::endl;
+}
+
+/**
+ * Writes the statistics of \p cache as a JSON object on its own line.
+ *
+ * @param out the stream to which the statistics are written
+ * @param cache the cache of learning nets
+ */
+void writeStats(std::ostream &out, const NetCache &cache)
+{
+	StringBuffer buffer;
+	Writer<StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("cacheHits");
+	writer.Uint64(cache.getHits());
+	writer.Key("cacheMisses");
+	writer.Uint64(cache.getMisses());
+	writer.Key("cacheSize");
+	writer.Uint64(cache.size());
+	writer.Key("cacheCapacity");
+	writer.Uint64(cache.capacity());
+	writer.EndObject();
+	out << buffer.GetString() << std::endl;
+}
+
+/**
+ * Writes the id and version of a published net as a JSON object on its own
+ * line.
+ *
+ * @param out the stream to which the object is written
+ * @param id id of the net
+ * @param version version of the publication
+ */
+void writePublished(std::ostream &out, const std::string &id,
+	unsigned long version)
+{
+	StringBuffer buffer;
+	Writer<StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("netId");
+	writer.String(id.c_str(), id.size());
+	writer.Key("version");
+	writer.Uint64(version);
+	writer.EndObject();
+	out << buffer.GetString() << std::endl;
+}
+
+/**
+ * Replaces the file at \p path by one holding \p content. The content is
+ * written to a new temporary file in the same directory first, which is then
+ * renamed, such that readers of the file never see a partially written one
+ * and concurrent writers of the same path do not share a temporary file.
+ *
+ * @param path path of the file
+ * @param content the new content of the file
+ * @return whether the file could be replaced
+ */
+bool replaceFile(const std::string &path, const std::string &content)
+{
+	std::size_t slash = path.rfind('/');
+	std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);
+	std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+	std::vector<char> tmpPath;
+	std::string tmpTemplate = dir + "/." + name + ".XXXXXX";
+	tmpPath.assign(tmpTemplate.begin(), tmpTemplate.end());
+	tmpPath.push_back('\0');
+
+	int fd = ::mkstemp(tmpPath.data());
+	if (fd < 0) {
+		return false;
+	}
+
+	// mkstemp() creates the file only readable by its owner.
+	bool written = ::fchmod(fd, 0644) == 0;
+	for (std::size_t pos = 0; written && pos < content.size(); ) {
+		ssize_t n = ::write(fd, content.data() + pos, content.size() - pos);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		written = n > 0;
+		pos += written ? n : 0;
+	}
+	written = ::close(fd) == 0 && written;
+
+	if (!written || std::rename(tmpPath.data(), path.c_str()) != 0) {
+		::unlink(tmpPath.data());
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Executes \p job(i) for each of the \p n entries of a batch request in
+ * parallel and writes one line with the result of each entry to \p out, in
+ * input order.
+ *
+ * @param out the stream to which the results are written
+ * @param pool pool running the jobs
+ * @param n number of entries
+ * @param job function taking the index of an entry and the stream to which
+ * its output is written, returns EXIT_SUCCESS or EXIT_FAILURE
+ */
+template<typename Job>
+void runBatch(std::ostream &out, ThreadPool &pool, SizeType n, const Job &job)
+{
+	std::vector<int> results(n, EXIT_FAILURE);
+	std::vector<std::string> outputs(n);
+	pool.parallelFor(n, [&](std::size_t i) {
+		std::ostringstream entryOut;
+		try {
+			results[i] = job(i, entryOut);
+		} catch (Exception &e) {
+			entryOut << e.what() << std::endl;
+		} catch (std::exception &e) {
+			entryOut << e.what() << std::endl;
+		} catch (const char *e) {
+			entryOut << e << std::endl;
+		}
+		outputs[i] = entryOut.str();
+	});
+
+	for (SizeType i = 0; i < n; i++) {
+		writeResult(out, results[i], outputs[i]);
 	}
+}
 
+/**
+ * Executes the action given by a JSON request.
+ *
+ * @param out the stream to which the output or error message is written
+ * @param context resources shared with other requests
+ * @param input JSON request as passed to the constructor of DataReader
+ * @return EXIT_FAILURE if the request failed, EXIT_SUCCESS otherwise
+ */
+template<typename... Input>
+int handleRequest(std::ostream &out, const RequestContext &context,
+	Input... input)
+{
+	NetCache *cache = context.cache;
 	try {
-		DataReader reader{argv[1]};
+		DataReader reader{input..., &context};
 
 		if (!reader.succeeded()) {
-			return reader.handleFailure();
+			return reader.handleFailure(out);
 		}
 
 		std::string action = reader.getAction();
 		// Execute action.
 		if (action == "check") {
-			LearningNet *net = reader.getNet();
-			NetworkChecker checker(*net);
+			// The checker changes the net, so it is never taken from the cache.
+			// Nets with many conditions are checked by all workers of the pool.
+			LearningNet *net = reader.readNet();
+			NetworkChecker checker(*net, true, context.pool);
 			delete net;
-			return checker.handleFailure();
+			return checker.handleFailure(out);
+		} else if (action == "checkMany") {
+			// Check each net independently, one line per net in input order.
+			runBatch(out, *context.pool, reader.getNetworkCount(),
+				[&reader, &context](SizeType i, std::ostream &netOut) {
+					std::unique_ptr<LearningNet> net{reader.readNet(i)};
+					NetworkChecker checker(*net, true, context.pool);
+					return checker.handleFailure(netOut);
+				});
+			return EXIT_SUCCESS;
 		} else if (action == "create") {
 			LearningNet *net = LearningNet::create(reader.getSections());
-			net->write();
+			net->write(out);
 			delete net;
 			return EXIT_SUCCESS;
+		} else if (action == "compile") {
+			std::unique_ptr<LearningNet> net{reader.readNet()};
+			std::ostringstream compiled;
+			net->compile(compiled);
+			std::string path = reader.getNetworkFile();
+			if (!replaceFile(path, compiled.str())) {
+				out << "Could not write compiled network to " << path << "." << std::endl;
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+		} else if (action == "stats") {
+			if (!cache) {
+				out << "Statistics are only available in --serve mode." << std::endl;
+				return EXIT_FAILURE;
+			}
+			writeStats(out, *cache);
+			return EXIT_SUCCESS;
+		} else if (action == "publish") {
+			if (!context.registry) {
+				out << "Publishing is only available in --serve mode." << std::endl;
+				return EXIT_FAILURE;
+			}
+			// Requests in progress keep the net published before.
+			std::string id = reader.getNetId();
+			unsigned long version =
+				context.registry->publish(id, reader.getSharedNet());
+			writePublished(out, id, version);
+			return EXIT_SUCCESS;
+		} else if (action == "unpublish") {
+			if (!context.registry) {
+				out << "Publishing is only available in --serve mode." << std::endl;
+				return EXIT_FAILURE;
+			}
+			std::string id = reader.getNetId();
+			if (!context.registry->remove(id)) {
+				out << "No network published under id \"" << id << "\"." << std::endl;
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
 		} else if (action == "recommend") {
-			// Get LearningNet, set given sections as completed and pass the
-			// net to the Recommender, which will set the appropriate unit nodes
-			// as active. Active nodes are set for every recommendation type.
-			LearningNet *net = reader.getNet();
-			Recommender rec(*net,
-				reader.getConditionValues(),
-				reader.getTestGrades()
-			);
-
-			if (reader.getRecType() == "path") {
-				// Set path with heuristically lowest costs as path attribute.
-				std::vector<lemon::ListDigraph::Node> recPath =
-					reader.hasOnlyNodeCosts() ?
-					rec.recPath(reader.getNodeCosts()) :
-					rec.recPath(reader.getNodePairCosts());
-
-				net->setRecommended(recPath);
-			} else if (reader.getRecType() == "next") {
-				// Set node with lowest costs as recommended path attribute.
-				std::vector<lemon::ListDigraph::Node>::const_iterator recIt =
-					reader.hasOnlyNodeCosts() ?
-					rec.recNext(reader.getNodeCosts()) :
-					rec.recNext(reader.getNodePairCosts());
-
-				std::vector<lemon::ListDigraph::Node> recPath;
-				if (recIt != rec.recActive().end()) {
-					recPath.push_back(*recIt);
-				}
-				net->setRecommended(recPath);
+			std::shared_ptr<const LearningNet> net = reader.getNet();
+			std::string recType = reader.getRecType();
+			std::unique_ptr<NodeCosts> nodeCosts;
+			std::unique_ptr<NodePairCosts> nodePairCosts;
+			if (recType != "active") {
+				readCosts(reader, nodeCosts, nodePairCosts);
 			}
 
-			net->write(std::cout, rec.getVisited());
-			delete net;
-			return rec.handleFailure();
+			// The transient data of the learner is freed at once at the end.
+			Arena arena;
+			int result = recommend(*net, reader.getSections(), recType,
+				reader.getConditionValues(), reader.getTestGrades(),
+				nodeCosts.get(), nodePairCosts.get(),
+				reader.getOutput() == "delta", out, arena.resource());
+			return result;
+		} else if (action == "recommendMany") {
+			// Read the net and aggregate the costs only once for all learners.
+			std::shared_ptr<const LearningNet> net = reader.getNet();
+			std::string recType = reader.getRecType();
+			std::unique_ptr<NodeCosts> nodeCosts;
+			std::unique_ptr<NodePairCosts> nodePairCosts;
+			if (recType != "active") {
+				readCosts(reader, nodeCosts, nodePairCosts);
+			}
+
+			// Write one JSON object per line and learner, in input order.
+			// The net is shared, each learner only gets its own state, which
+			// is allocated from the arena of the thread running it. The arena
+			// is released before and after each learner.
+			bool delta = reader.getOutput() == "delta";
+			runBatch(out, *context.pool, reader.getLearnerCount(),
+				[&](SizeType i, std::ostream &learnerOut) {
+					Arena::Scope arena = Arena::local();
+					return recommend(*net, reader.getSections(i), recType,
+						reader.getConditionValues(i), reader.getTestGrades(i),
+						nodeCosts.get(), nodePairCosts.get(), delta, learnerOut,
+						arena.resource());
+				});
+			return EXIT_SUCCESS;
 		}
 	} catch (Exception &e) {
-		std::cout << e.what() << std::endl;
+		out << e.what() << std::endl;
 		return EXIT_FAILURE;
+	} catch (std::exception &e) {
+		// A server must survive malformed requests, so report them instead.
+		out << e.what() << std::endl;
+		return EXIT_FAILURE;
+	} catch (const char *e) {
+		out << e << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_FAILURE;
+}
+
+
+/**
+ * Reads the whole content of the file descriptor \p fd.
+ *
+ * @param fd file descriptor to read from
+ * @param data is assigned the null-terminated content of \p fd
+ * @return whether \p fd could be read until its end
+ */
+bool readAll(int fd, std::vector<char> &data)
+{
+	constexpr std::size_t chunkSize = 1 << 16;
+	std::size_t length = 0;
+	while (true) {
+		data.resize(length + chunkSize);
+		ssize_t n = ::read(fd, data.data() + length, chunkSize);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0) {
+			return false;
+		}
+		if (n == 0) {
+			break;
+		}
+		length += n;
 	}
+	data.resize(length + 1);
+	data[length] = '\0';
+	return true;
+}
+
+/**
+ * Executes the JSON request in the file at \p path, which is memory-mapped
+ * instead of being read into a buffer.
+ *
+ * @param path path of the file containing the JSON request
+ * @param out the stream to which the output or error message is written
+ * @param context resources shared with other requests
+ * @return EXIT_FAILURE if the request failed, EXIT_SUCCESS otherwise
+ */
+int handleFile(const char *path, std::ostream &out,
+	const RequestContext &context)
+{
+	int fd = ::open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || ::fstat(fd, &st) < 0) {
+		out << "Could not open input file " << path << "." << std::endl;
+		if (fd >= 0) {
+			::close(fd);
+		}
+		return EXIT_FAILURE;
+	}
+
+	std::size_t length = st.st_size;
+	if (length == 0) {
+		::close(fd);
+		return handleRequest(out, context, "", length);
+	}
+
+	void *data = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		out << "Could not map input file " << path << "." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	int result = handleRequest(out, context,
+		static_cast<const char*>(data), length);
+	::munmap(data, length);
+	return result;
+}
+
+/**
+ * Reads the options following the mode arguments of the executable:
+ * "--threads <n>" sets the number of worker threads, "--cache-size <n>"
+ * the number of learning nets cached in --serve mode and "--net-dir <path>"
+ * the directory holding all network files.
+ *
+ * @param first index of the first option in \p argv
+ * @param argc number of arguments
+ * @param argv arguments of the executable
+ * @param threads is assigned the number of worker threads if given
+ * @param cacheSize is assigned the cache size if given
+ * @param netDir is assigned the directory of network files if given
+ * @return whether all options were valid, if not an error is written to
+ * std::cout
+ */
+bool readOptions(int first, int argc, char *argv[],
+	unsigned int &threads, std::size_t &cacheSize, std::string &netDir)
+{
+	for (int i = first; i < argc; i += 2) {
+		std::string option = argv[i];
+		if (option != "--threads" && option != "--cache-size" &&
+				option != "--net-dir") {
+			std::cout << "Unknown option " << option << "." << std::endl;
+			return false;
+		}
+		if (i + 1 >= argc) {
+			std::cout << "No value given for " << option << "." << std::endl;
+			return false;
+		}
+		if (option == "--net-dir") {
+			netDir = argv[i + 1];
+			if (netDir.empty()) {
+				std::cout << "Invalid value given for " << option << "." << std::endl;
+				return false;
+			}
+			continue;
+		}
+
+		try {
+			unsigned long value = std::stoul(argv[i + 1]);
+			if (option == "--threads") {
+				threads = value;
+			} else {
+				cacheSize = value;
+			}
+		} catch (std::exception &e) {
+			std::cout << "Invalid value given for " << option << "." << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		std::cout << "No argument given to executable." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Modes with a path take one more argument before the options.
+	std::string mode = argv[1];
+	bool hasPath = mode == "--serve" || mode == "--input";
+	if (hasPath && argc < 3) {
+		std::cout << "No path given for " << mode << "." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	unsigned int threads = std::thread::hardware_concurrency();
+	std::size_t cacheSize = 64;
+	std::string netDir;
+	if (!readOptions(hasPath ? 3 : 2, argc, argv, threads, cacheSize, netDir)) {
+		return EXIT_FAILURE;
+	}
+	// The workers are only started once a request runs jobs in parallel.
+	ThreadPool pool{threads};
+
+	// Serve requests over a Unix domain socket until terminated. Clients may
+	// only use network files in the directory given by --net-dir.
+	if (mode == "--serve") {
+		NetCache cache{cacheSize};
+		NetRegistry registry;
+		RequestContext context{&cache, &registry, &pool, &netDir};
+		Server server{argv[2], [&context](char *data, std::ostream &out) {
+			return handleRequest(out, context, data);
+		}, &pool};
+		server.run();
+		return server.handleFailure();
+	}
+
+	RequestContext context{nullptr, nullptr, &pool,
+		netDir.empty() ? nullptr : &netDir};
+
+	// Read the request from stdin, which is not limited in size like argv.
+	if (mode == "--stdin") {
+		std::vector<char> data;
+		if (!readAll(STDIN_FILENO, data)) {
+			std::cout << "Could not read input from stdin." << std::endl;
+			return EXIT_FAILURE;
+		}
+		return handleRequest(std::cout, context, data.data());
+	}
+
+	// Read the request from a file.
+	if (mode == "--input") {
+		return handleFile(argv[2], std::cout, context);
+	}
+
+	return handleRequest(std::cout, context, argv[1]);
 }
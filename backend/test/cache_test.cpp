@@ -0,0 +1,66 @@
+#include <catch.hpp>
+#include "resources.hpp"
+#include <learningnet/NetCache.hpp>
+
+using namespace learningnet;
+
+std::string readNetwork(const std::string &filename)
+{
+	std::ifstream f(resourcePath + "valid/" + filename + ".lgf");
+	REQUIRE(f);
+
+	std::ostringstream netss;
+	netss << f.rdbuf();
+	return netss.str();
+}
+
+TEST_CASE("NetCache","[cache]") {
+	std::string a = readNetwork("condition");
+	std::string b = readNetwork("no_condition");
+	std::string c = readNetwork("example_swe");
+
+	SECTION("repeated networks are read once") {
+		NetCache cache{2};
+		auto netA = cache.get(a.data(), a.size());
+		CHECK(cache.get(a.data(), a.size()) == netA);
+
+		// A copy of the same text is found as well.
+		std::string copyA = a;
+		CHECK(cache.get(copyA.data(), copyA.size()) == netA);
+		CHECK(cache.getHits() == 2);
+		CHECK(cache.getMisses() == 1);
+		CHECK(cache.size() == 1);
+	}
+
+	SECTION("least recently used network is evicted") {
+		NetCache cache{2};
+		auto netA = cache.get(a.data(), a.size());
+		auto netB = cache.get(b.data(), b.size());
+		cache.get(a.data(), a.size());
+		cache.get(c.data(), c.size()); // evicts b
+		CHECK(cache.size() == 2);
+
+		CHECK(cache.get(a.data(), a.size()) == netA);
+		CHECK(cache.get(b.data(), b.size()) != netB);
+		CHECK(cache.getHits() == 2);
+		CHECK(cache.getMisses() == 4);
+
+		// Evicted nets stay valid while in use.
+		CHECK(countNodes(*netB) > 0);
+	}
+
+	SECTION("capacity 0 disables caching") {
+		NetCache cache{0};
+		auto netA = cache.get(a.data(), a.size());
+		CHECK(cache.get(a.data(), a.size()) != netA);
+		CHECK(cache.size() == 0);
+		CHECK(cache.getMisses() == 2);
+	}
+
+	SECTION("invalid networks are not cached") {
+		NetCache cache{2};
+		std::string invalid = "@nodes\nlabel\n0\n";
+		CHECK_THROWS(cache.get(invalid.data(), invalid.size()));
+		CHECK(cache.size() == 0);
+	}
+}
@@ -4,8 +4,10 @@
 
 using namespace learningnet;
 
-void checkNet(LearningNet &net, bool valid, bool useCompression) {
-	NetworkChecker checker(net, useCompression);
+void checkNet(LearningNet &net, bool valid, bool useCompression,
+		ThreadPool *pool = nullptr,
+		uint64_t maxSlicedCombinations = NetworkChecker::MAX_SLICED_COMBINATIONS) {
+	NetworkChecker checker(net, useCompression, pool, maxSlicedCombinations);
 	CHECKED_ELSE(checker.succeeded() == valid) {
 		checker.handleFailure();
 		net.write();
@@ -31,3 +33,64 @@ TEST_CASE("NetworkChecker","[check]") {
 		}
 	}
 }
+
+TEST_CASE("NetworkChecker reports first combination","[check]") {
+	// The target is only reached for branch x of condition 1 together with
+	// branch y of condition 2, condition 2 is not reached for other branches.
+	std::string lgf =
+		"@nodes\n"
+		"label type ref\n"
+		"0 11 1\n"
+		"1 11 2\n"
+		"2 0 10\n"
+		"3 0 11\n"
+		"4 20 1\n"
+		"5 0 12\n"
+		"@arcs\n"
+		"    condition\n"
+		"0 5 \"SONST\"\n"
+		"0 1 \"x\"\n"
+		"1 3 \"SONST\"\n"
+		"1 2 \"y\"\n"
+		"2 4 \"\"\n"
+		"@attributes\n"
+		"target 4\n";
+	ThreadPool pool{4};
+	for (ThreadPool *usedPool : {static_cast<ThreadPool*>(nullptr), &pool}) {
+		for (uint64_t maxSliced : {uint64_t{0}, NetworkChecker::MAX_SLICED_COMBINATIONS}) {
+			LearningNet net{lgf};
+			NetworkChecker checker(net, false, usedPool, maxSliced);
+			REQUIRE_FALSE(checker.succeeded());
+
+			// Values of the first condition id change fastest, also if the
+			// combinations are checked in parallel or bit-sliced.
+			std::ostringstream error;
+			checker.handleFailure(error);
+			CHECK(error.str() == "No path to target for condition branches:\n"
+				"1: SONST\n"
+				"2: y");
+		}
+	}
+}
+
+TEST_CASE("NetworkChecker searches","[check]") {
+	ThreadPool pool{4};
+	for (ThreadPool *usedPool : {static_cast<ThreadPool*>(nullptr), &pool}) {
+		// Either branch the search at all conditions or check every
+		// combination bit-sliced.
+		for (uint64_t maxSliced : {uint64_t{0}, ~uint64_t{0}}) {
+			std::string name = std::string(usedPool ? "with" : "without") +
+				" pool, " + (maxSliced ? "bit-sliced" : "branched");
+
+			SECTION(name) {
+				for_each_file("valid", [&](LearningNet &net) {
+					checkNet(net, true, false, usedPool, maxSliced);
+				});
+
+				for_each_file("invalid", [&](LearningNet &net) {
+					checkNet(net, false, false, usedPool, maxSliced);
+				});
+			}
+		}
+	}
+}
@@ -0,0 +1,164 @@
+#include <catch.hpp>
+#include "resources.hpp"
+#include <learningnet/LearningNet.hpp>
+#include <learningnet/NetworkChecker.hpp>
+
+using namespace learningnet;
+
+/**
+ * @param net learning net to compile
+ * @return the compiled net, aligned to 8 bytes
+ */
+std::vector<uint64_t> compileNet(const LearningNet &net)
+{
+	std::ostringstream compiled;
+	net.compile(compiled);
+	std::string bytes = compiled.str();
+	std::vector<uint64_t> aligned((bytes.size() + 7) / 8);
+	std::memcpy(aligned.data(), bytes.data(), bytes.size());
+	return aligned;
+}
+
+void checkRoundTrip(const LearningNet &net)
+{
+	std::vector<uint64_t> compiled = compileNet(net);
+	const char *data = reinterpret_cast<const char*>(compiled.data());
+	std::size_t length = compiled.size() * 8;
+	REQUIRE(CompiledNet::isCompiled(data, length));
+
+	LearningNet loaded{CompiledNet(data, length)};
+	CHECK(countNodes(loaded) == countNodes(net));
+	CHECK(countArcs(loaded) == countArcs(net));
+	CHECK(loaded.id(loaded.getTarget()) == net.id(net.getTarget()));
+	for (auto v : net.nodes()) {
+		CHECK(loaded.getType(v) == net.getType(v));
+		CHECK(loaded.getSection(v) == net.getSection(v));
+	}
+	for (auto a : net.arcs()) {
+		CHECK(loaded.id(loaded.source(a)) == net.id(net.source(a)));
+		CHECK(loaded.id(loaded.target(a)) == net.id(net.target(a)));
+		CHECK(loaded.getConditionBranch(a) == net.getConditionBranch(a));
+	}
+
+	// The precomputed structure is loaded instead of being recomputed.
+	REQUIRE(loaded.isPrecomputed());
+	const StaticGraph &graph = *loaded.getStaticGraph();
+	StaticGraph built = loaded.buildStaticGraph();
+	for (auto v : loaded.nodes()) {
+		int id = loaded.id(v);
+		CHECK(graph.inDegree(id) == built.inDegree(id));
+		CHECK(graph.ref(id) == built.ref(id));
+		CHECK(graph.nodeClass(id) == built.nodeClass(id));
+		REQUIRE(graph.outBegin(id) == built.outBegin(id));
+		REQUIRE(graph.outEnd(id) == built.outEnd(id));
+		for (int i = graph.outBegin(id); i < graph.outEnd(id); i++) {
+			CHECK(graph.arc(i) == built.arc(i));
+			CHECK(graph.target(i) == built.target(i));
+			CHECK(graph.branch(i) == built.branch(i));
+		}
+	}
+	CHECK(loaded.getTopologicalOrder() == net.getTopologicalOrder());
+	CHECK(loaded.isAcyclic() == net.isAcyclic());
+	CHECK(loaded.getSources() == net.getSources());
+	for (auto v : net.nodes()) {
+		if (net.isUnit(v)) {
+			CHECK(loaded.getUnit(net.getSection(v)) == net.getUnit(net.getSection(v)));
+			CHECK(loaded.getSectionIndex()->unitIndex(loaded.id(v)) ==
+				net.getSectionIndex()->unitIndex(net.id(v)));
+		}
+	}
+
+	// Both nets are written the same way.
+	std::ostringstream netOut, loadedOut;
+	net.write(netOut);
+	loaded.write(loadedOut);
+	CHECK(netOut.str() == loadedOut.str());
+}
+
+TEST_CASE("Compiled nets","[compile]") {
+	SECTION("round trip") {
+		for_each_file("valid", [](LearningNet &net) {
+			checkRoundTrip(net);
+		});
+		for_each_file("invalid", [](LearningNet &net) {
+			checkRoundTrip(net);
+		});
+	}
+
+	SECTION("precomputed structure matches a fresh computation") {
+		for_each_file("valid", [](LearningNet &net) {
+			CHECK(net.isAcyclic());
+			CHECK(net.getTopologicalOrder().size() ==
+				static_cast<std::size_t>(countNodes(net)));
+			for (auto v : net.getSources()) {
+				CHECK(net.isSource(v));
+			}
+			CHECK(net.getUnit(-42) == lemon::INVALID);
+
+			// Unit indices are dense and follow the node ids.
+			const SectionIndex &units = *net.getSectionIndex();
+			int previous = -1;
+			for (int i = 0; i < units.unitCount(); i++) {
+				lemon::ListDigraph::Node v = net.nodeFromId(units.node(i));
+				CHECK(net.isUnit(v));
+				CHECK(units.node(i) > previous);
+				CHECK(units.unitIndex(units.node(i)) == i);
+				CHECK(units.section(i) == net.getSection(v));
+				CHECK(units.units(units.section(i))[0] == net.getSectionIndex()->unitIndex(
+					net.id(net.getUnit(units.section(i)))));
+				previous = units.node(i);
+			}
+			CHECK(units.units(-42).empty());
+
+			// Compiled nets are checked the same way.
+			std::vector<uint64_t> compiled = compileNet(net);
+			LearningNet loaded{CompiledNet(
+				reinterpret_cast<const char*>(compiled.data()), compiled.size() * 8)};
+			NetworkChecker checker{loaded};
+			CHECK(checker.succeeded());
+		});
+	}
+
+	SECTION("section ids are parsed as written by std::to_string") {
+		int section = 0;
+		for (int id : {0, 7, -7, 1234, INT32_MAX, INT32_MIN}) {
+			std::string str = std::to_string(id);
+			CHECK(SectionIndex::parse(str.c_str(), str.size(), section));
+			CHECK(section == id);
+		}
+		for (std::string str : {"", "-", "007", "-0", "+7", " 7", "7a", "2147483648"}) {
+			CHECK(!SectionIndex::parse(str.c_str(), str.size(), section));
+		}
+	}
+
+	SECTION("corrupt nets are rejected") {
+		for_file("valid", "example_swe", [](LearningNet &net) {
+			std::vector<uint64_t> compiled = compileNet(net);
+			const char *data = reinterpret_cast<const char*>(compiled.data());
+
+			// Truncated directory.
+			CHECK_THROWS_AS(LearningNet(data, 24), std::runtime_error);
+
+			// Other version.
+			std::vector<uint64_t> otherVersion = compiled;
+			reinterpret_cast<uint32_t*>(otherVersion.data())[2] += 1;
+			CHECK_THROWS_AS(LearningNet(
+				reinterpret_cast<const char*>(otherVersion.data()),
+				otherVersion.size() * 8), std::runtime_error);
+
+			// Out-arc that does not exist. The directory entries of 24 bytes
+			// follow the header of 24 bytes.
+			std::vector<uint64_t> wrongOutArc = compiled;
+			char *bytes = reinterpret_cast<char*>(wrongOutArc.data());
+			uint32_t sectionCount = reinterpret_cast<uint32_t*>(bytes)[4];
+			for (uint32_t i = 0; i < sectionCount; i++) {
+				uint64_t *entry = reinterpret_cast<uint64_t*>(bytes + 24 + 24 * i);
+				if (static_cast<uint32_t>(entry[0]) == CompiledSection::outArcIds) {
+					reinterpret_cast<uint32_t*>(bytes + entry[1])[0] = countArcs(net);
+				}
+			}
+			CHECK_THROWS_AS(LearningNet(bytes, wrongOutArc.size() * 8),
+				std::runtime_error);
+		});
+	}
+}
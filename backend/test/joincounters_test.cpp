@@ -0,0 +1,51 @@
+#include <catch.hpp>
+#include <learningnet/JoinCounters.hpp>
+
+using namespace learningnet;
+
+TEST_CASE("JoinCounters","[join]") {
+	JoinCounters counters{4};
+	for (int v = 0; v < 4; v++) {
+		CHECK(counters.get(v) == 0);
+	}
+
+	SECTION("increment") {
+		CHECK(counters.increment(1) == 1);
+		CHECK(counters.increment(1) == 2);
+		CHECK(counters.increment(3) == 1);
+		CHECK(counters.get(0) == 0);
+		CHECK(counters.get(1) == 2);
+		CHECK(counters.get(3) == 1);
+	}
+
+	SECTION("reset all") {
+		counters.increment(1);
+		counters.increment(2);
+		counters.reset();
+		for (int v = 0; v < 4; v++) {
+			CHECK(counters.get(v) == 0);
+		}
+		CHECK(counters.increment(1) == 1);
+	}
+
+	SECTION("reset one") {
+		counters.increment(1);
+		counters.increment(2);
+		counters.reset(1);
+		CHECK(counters.get(1) == 0);
+		CHECK(counters.get(2) == 1);
+		CHECK(counters.increment(1) == 1);
+	}
+
+	SECTION("decrement") {
+		counters.increment(1);
+		counters.increment(1);
+		counters.increment(2);
+		counters.decrement(1);
+		CHECK(counters.get(1) == 1);
+		CHECK(counters.get(2) == 1);
+		counters.decrement(2);
+		CHECK(counters.get(2) == 0);
+		CHECK(counters.increment(2) == 1);
+	}
+}
@@ -1,10 +1,35 @@
+// Check each cost lookup of the Recommender.
+#define LN_DEBUG_COSTS
+
 #include <catch.hpp>
 #include "resources.hpp"
 #include <random>
+#include <learningnet/Arena.hpp>
 #include <learningnet/Recommender.hpp>
 
 using namespace learningnet;
 
+//! Memory resource counting the bytes allocated from it.
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+	std::size_t allocated = 0; //!< bytes allocated so far
+
+private:
+	void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+		allocated += bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+		return this == &other;
+	}
+};
+
 double getCost(const NodeCosts &costs,
 		const lemon::ListDigraph::Node &prev,
 		const lemon::ListDigraph::Node &v)
@@ -16,11 +41,16 @@ double getCost(const NodePairCosts &costs,
 		const lemon::ListDigraph::Node &prev,
 		const lemon::ListDigraph::Node &v)
 {
-	return costs.at(prev).at(v);
+	if (prev == lemon::INVALID) {
+		// Without a previous node, the Recommender uses the cost sum over all
+		// node pairs starting at v.
+		return costs.row(v).sum();
+	}
+	return costs(prev, v);
 }
 
 template<typename CostType>
-void checkNet(LearningNet &net,
+void checkNet(const LearningNet &net,
 	const ConditionMap &conditionVals,
 	const TestMap &testGrades,
 	const CostType &costs)
@@ -30,11 +60,42 @@ void checkNet(LearningNet &net,
 		rec.recNext(costs);
 
 	for (auto v : rec.recActive()) {
-		CHECK(net.getType(v) == NodeType::active);
+		CHECK(rec.getState().getType(v) == NodeType::active);
+	}
+
+	// The delta holds the ids of the active nodes and a digit per 4 arcs.
+	std::vector<int> activeIds;
+	for (auto v : rec.recActive()) {
+		activeIds.push_back(net.id(v));
+	}
+	std::sort(activeIds.begin(), activeIds.end());
+	std::ostringstream expectedActive;
+	expectedActive << "{\"active\":[";
+	for (std::size_t i = 0; i < activeIds.size(); i++) {
+		expectedActive << (i == 0 ? "" : ",") << activeIds[i];
 	}
+	expectedActive << "],";
+
+	auto visited = rec.getVisited();
+	std::ostringstream delta;
+	rec.getState().writeDelta(delta, &visited);
+	CHECK(delta.str().rfind(expectedActive.str(), 0) == 0);
+	std::string visitedKey = "\"visited\":\"";
+	std::size_t bitmapStart = delta.str().find(visitedKey) + visitedKey.size();
+	CHECK(delta.str().find('"', bitmapStart) - bitmapStart ==
+		static_cast<std::size_t>(net.maxArcId() + 4) / 4);
 
 	std::vector<lemon::ListDigraph::Node> learningPath = rec.recPath(costs);
 
+	// Searches allocating from another memory resource find the same nodes.
+	CountingResource counting;
+	{
+		Recommender countingRec(net, conditionVals, testGrades, &counting);
+		CHECK(countingRec.recActive() == rec.recActive());
+		CHECK(countingRec.recPath(costs) == learningPath);
+	}
+	CHECK(counting.allocated > 0);
+
 	// Check source.
 	bool hasConnectiveSources = false;
 	for (auto v : net.nodes()) {
@@ -43,15 +104,22 @@ void checkNet(LearningNet &net,
 			break;
 		}
 	}
-	if (!hasConnectiveSources) {
+	if (!hasConnectiveSources && !learningPath.empty()) {
 		CHECK(net.isSource(learningPath.front()));
 	}
 
 	// Check target.
-	lemon::ListDigraph::Node last = learningPath.back();
 	lemon::ListDigraph::Node tgt = net.getTarget();
 	if (net.isUnit(tgt)) {
-		CHECK(net.isTarget(last));
+		REQUIRE(!learningPath.empty());
+		CHECK(net.isTarget(learningPath.back()));
+	}
+
+	// The net itself must not be changed by the Recommender.
+	for (auto v : net.nodes()) {
+		if (net.isUnit(v)) {
+			CHECK(net.getType(v) != NodeType::active);
+		}
 	}
 
 	// The following check only works since recPath() uses a local greedy search.
@@ -62,11 +130,13 @@ void checkNet(LearningNet &net,
 	// Check whether iterative recommendation of active nodes could lead to the
 	// learning path.
 	lemon::ListDigraph::Node prev = lemon::INVALID;
+	LearnerState state(net);
 	for (auto v : learningPath) {
 		CHECK(net.isUnit(v));
-		Recommender newRec(net, conditionVals, testGrades); // active nodes are set
-		CHECK(net.getType(v) == NodeType::active);
-		net.setType(v, NodeType::completed);
+		Recommender newRec(net, state, conditionVals, testGrades);
+		state = newRec.getState(); // active nodes are set
+		CHECK(state.getType(v) == NodeType::active);
+		state.setType(v, NodeType::completed);
 
 		// The following check only works since recPath() uses a local greedy search.
 		// Ensure that v has the lowest cost out of all active nodes.
@@ -100,7 +170,7 @@ void checkNet(LearningNet &net) {
 	}
 
 	SECTION("with node costs") {
-		NodeCosts costs;
+		NodeCosts costs{net};
 		for (auto v : net.nodes()) {
 			if (net.isUnit(v)) {
 				costs[v] = unif(rand);
@@ -110,18 +180,34 @@ void checkNet(LearningNet &net) {
 	}
 
 	SECTION("with node pair costs") {
-		NodePairCosts costs;
+		NodePairCosts costs{net};
 		for (auto v : net.nodes()) {
 			if (net.isUnit(v)) {
 				for (auto w : net.nodes()) {
 					if (net.isUnit(w)) {
-						costs[v][w] = unif(rand);
+						costs.add(v, w, unif(rand));
 					}
 				}
 			}
 		}
 		checkNet(net, conditionVals, testGrades, costs);
 	}
+
+	SECTION("with sparse node pair costs") {
+		std::vector<std::tuple<lemon::ListDigraph::Node,
+			lemon::ListDigraph::Node, double>> entries;
+		for (auto v : net.nodes()) {
+			if (net.isUnit(v)) {
+				for (auto w : net.nodes()) {
+					if (net.isUnit(w) && unif(rand) < 20) {
+						entries.emplace_back(v, w, unif(rand));
+					}
+				}
+			}
+		}
+		checkNet(net, conditionVals, testGrades,
+			NodePairCosts::sparse(net, entries));
+	}
 }
 
 TEST_CASE("Recommender","[rec]") {
@@ -129,3 +215,152 @@ TEST_CASE("Recommender","[rec]") {
 		checkNet(net);
 	});
 }
+
+TEST_CASE("NodeCosts","[rec]") {
+	for_file("valid", "example_swe", [](LearningNet &net) {
+		NodeCosts costs{net};
+		for (auto v : net.nodes()) {
+			CHECK(!costs.hasCost(v));
+			if (net.isUnit(v)) {
+				costs[v] += net.id(v);
+			}
+		}
+
+		for (auto v : net.nodes()) {
+			if (net.isUnit(v)) {
+				CHECK(costs.hasCost(v));
+				CHECK(costs.at(v) == net.id(v));
+			} else {
+				CHECK_THROWS_AS(costs.at(v), std::out_of_range);
+				const NodeCosts &constCosts = costs;
+				CHECK_THROWS_AS(constCosts[v], std::out_of_range);
+			}
+		}
+		CHECK(!costs.hasCost(lemon::INVALID));
+	});
+}
+
+TEST_CASE("Arena","[rec]") {
+	// Each use of the arena of a thread starts at its first block.
+	void *first;
+	{
+		Arena::Scope arena = Arena::local();
+		first = arena.resource()->allocate(100);
+		void *second = arena.resource()->allocate(Arena::BLOCK_SIZE);
+		CHECK(second != first);
+	}
+	{
+		Arena::Scope arena = Arena::local();
+		CHECK(arena.resource()->allocate(100) == first);
+
+		// Nested uses would invalidate the memory of the outer one.
+		CHECK_THROWS_AS(Arena::local(), std::logic_error);
+		CHECK(arena.resource()->allocate(100) != first);
+	}
+}
+
+TEST_CASE("NodePairCosts","[rec]") {
+	for_file("valid", "example_swe", [](LearningNet &net) {
+		std::vector<lemon::ListDigraph::Node> units;
+		for (auto v : net.nodes()) {
+			if (net.isUnit(v)) {
+				units.push_back(v);
+			}
+		}
+		REQUIRE(units.size() >= 2);
+
+		// Equal pairs are added up, all other pairs cost 0.
+		lemon::ListDigraph::Node v = units[0];
+		lemon::ListDigraph::Node w = units[1];
+		NodePairCosts sparse = NodePairCosts::sparse(net,
+			{std::make_tuple(v, w, 1.5), std::make_tuple(w, v, 2.0),
+				std::make_tuple(v, w, 3.0)});
+		NodePairCosts dense{net};
+		dense.add(v, w, 4.5);
+		dense.add(w, v, 2.0);
+
+		CHECK(sparse.getStorage() == NodePairCosts::Storage::sparse);
+		CHECK(dense.getStorage() == NodePairCosts::Storage::matrix);
+		CHECK(static_cast<std::size_t>(sparse.unitCount()) == units.size());
+		for (auto x : units) {
+			CHECK(sparse.unitIndex(x) == dense.unitIndex(x));
+			CHECK(sparse.row(x).sum() == dense.row(x).sum());
+			for (auto y : units) {
+				CHECK(sparse(x, y) == dense(x, y));
+			}
+		}
+		CHECK(sparse(v, w) == 4.5);
+		CHECK(sparse.row(w).sum() == 2.0);
+		for (auto x : net.nodes()) {
+			if (!net.isUnit(x)) {
+				CHECK(sparse.unitIndex(x) == -1);
+			}
+		}
+		CHECK_THROWS_AS(sparse.add(v, w, 1.0), std::logic_error);
+
+		// Codes are dequantized exactly and summed up before dequantizing.
+		NodePairCosts small = NodePairCosts::quantized(net, 200, 0.5, 2.0);
+		NodePairCosts large = NodePairCosts::quantized(net, 300, 0.5, 2.0);
+		CHECK(small.getStorage() == NodePairCosts::Storage::quantized8);
+		CHECK(large.getStorage() == NodePairCosts::Storage::quantized16);
+		for (NodePairCosts *costs : {&small, &large}) {
+			costs->addCode(v, w, 100);
+			costs->addCode(v, w, 55);
+			costs->addCode(w, v, 3);
+			CHECK((*costs)(v, w) == (155 * 0.5) / 2.0);
+			CHECK((*costs)(w, v) == (3 * 0.5) / 2.0);
+			CHECK((*costs)(v, v) == 0.0);
+			CHECK(costs->row(v).sum() == (155 * 0.5) / 2.0);
+			CHECK_THROWS_AS(costs->add(v, w, 1.0), std::logic_error);
+		}
+		CHECK_THROWS_AS(small.addCode(v, w, 101), std::overflow_error);
+		large.addCode(v, w, 65000);
+		CHECK(large(v, w) == (65155 * 0.5) / 2.0);
+		CHECK_THROWS_AS(NodePairCosts::quantized(net, 70000, 1.0, 1.0),
+			std::invalid_argument);
+		CHECK_THROWS_AS(dense.addCode(v, w, 1), std::logic_error);
+
+		// Symmetric costs are added to both orders of a pair.
+		for (NodePairCosts *costs : {&sparse, &dense, &small}) {
+			CHECK(!costs->hasSymmetric());
+			double before = (*costs)(w, v);
+			costs->addSymmetric(v, w, 0.25);
+			CHECK(costs->hasSymmetric());
+			CHECK((*costs)(w, v) == before + 0.25);
+			CHECK((*costs)(v, v) == 0.0);
+			for (auto x : units) {
+				if (x != v && x != w) {
+					costs->addSymmetric(x, v, 1.0);
+					CHECK((*costs)(v, x) == (*costs)(x, v));
+				}
+			}
+			CHECK_THROWS_AS(costs->addSymmetric(v, v, 1.0), std::invalid_argument);
+		}
+		CHECK(sparse.row(v).sum() == dense.row(v).sum());
+		CHECK(sparse.row(w).sum() == 2.0 + 0.25);
+
+		// Kernels are computed from the attributes of both nodes of a pair.
+		std::vector<double> attributes(sparse.unitCount(),
+			std::numeric_limits<double>::quiet_NaN());
+		attributes[sparse.unitIndex(v)] = 1.0;
+		attributes[sparse.unitIndex(w)] = 4.0;
+		NodePairCosts kernels{net};
+		kernels.addKernel(PairCostKernel(PairCostKernel::Kind::absoluteDifference,
+			2.0, 0.0, 1.0, 2.0, attributes));
+		kernels.addKernel(PairCostKernel(PairCostKernel::Kind::squaredDifference,
+			1.0, 0.0, 1.0, 1.0, attributes));
+		kernels.addKernel(PairCostKernel(PairCostKernel::Kind::threshold,
+			5.0, 2.0, 2.0, 1.0, attributes));
+		double expected = (3.0 * 2.0) / 2.0 + 9.0 + 10.0;
+		CHECK(kernels(v, w) == expected);
+		CHECK(kernels(w, v) == expected);
+		CHECK(kernels(v, v) == 0.0);
+		CHECK(kernels.row(v).sum() == expected);
+		for (auto x : units) {
+			if (x != v && x != w) {
+				CHECK(kernels(v, x) == 0.0);
+				CHECK(kernels(x, w) == 0.0);
+			}
+		}
+	});
+}
@@ -0,0 +1,57 @@
+#include <catch.hpp>
+#include "resources.hpp"
+#include <learningnet/NetRegistry.hpp>
+#include <thread>
+
+using namespace learningnet;
+
+std::shared_ptr<const LearningNet> readSharedNet(const std::string &filename)
+{
+	std::ifstream f(resourcePath + "valid/" + filename + ".lgf");
+	REQUIRE(f);
+
+	std::ostringstream netss;
+	netss << f.rdbuf();
+	return std::make_shared<const LearningNet>(netss.str());
+}
+
+TEST_CASE("NetRegistry","[registry]") {
+	auto a = readSharedNet("condition");
+	auto b = readSharedNet("no_condition");
+	NetRegistry registry;
+
+	SECTION("publish replaces nets") {
+		CHECK(registry.get("course") == nullptr);
+		CHECK(registry.publish("course", a) == 1);
+		CHECK(registry.get("course") == a);
+		CHECK(registry.publish("course", b) == 2);
+		CHECK(registry.get("course") == b);
+		CHECK(registry.remove("course"));
+		CHECK(!registry.remove("course"));
+		CHECK(registry.get("course") == nullptr);
+	}
+
+	SECTION("snapshots are not affected by later publications") {
+		registry.publish("course", a);
+		auto snapshot = registry.snapshot();
+		registry.publish("course", b);
+		registry.publish("other", b);
+		CHECK(snapshot->at("course").net == a);
+		CHECK(snapshot->at("course").version == 1);
+		CHECK(snapshot->count("other") == 0);
+	}
+
+	SECTION("readers see whole publications") {
+		registry.publish("course", a);
+		std::thread writer{[&]() {
+			for (int i = 0; i < 1000; i++) {
+				registry.publish("course", i % 2 ? a : b);
+			}
+		}};
+		for (int i = 0; i < 1000; i++) {
+			auto net = registry.get("course");
+			CHECK((net == a || net == b));
+		}
+		writer.join();
+	}
+}
@@ -0,0 +1,258 @@
+#include <catch.hpp>
+#include "resources.hpp"
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+using namespace learningnet;
+
+const std::string executable = "./learningnet-pathfinder";
+
+/**
+ * Runs the executable in --serve mode for the lifetime of this object.
+ */
+class ServerProcess
+{
+private:
+	std::string m_socketPath;
+
+	std::string m_netDir;
+
+	pid_t m_pid;
+
+public:
+	/**
+	 * @param netDir directory of network files
+	 */
+	explicit ServerProcess(const std::string &netDir)
+		: m_socketPath{"server_test." + std::to_string(::getpid()) + ".sock"}
+		, m_netDir{netDir}
+		, m_pid{::fork()}
+	{
+		if (m_pid == 0) {
+			::execl(executable.c_str(), executable.c_str(), "--serve",
+				m_socketPath.c_str(), "--threads", "2",
+				"--net-dir", m_netDir.c_str(), nullptr);
+			::_exit(127);
+		}
+	}
+
+	~ServerProcess() {
+		stop();
+	}
+
+	/**
+	 * Connects to the server, retrying until its socket is set up.
+	 *
+	 * @return file descriptor of the connection or -1 on failure
+	 */
+	int connect() const {
+		struct sockaddr_un addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		std::strncpy(addr.sun_path, m_socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+		for (int attempt = 0; attempt < 100; attempt++) {
+			int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+					sizeof(addr)) == 0) {
+				return fd;
+			}
+			::close(fd);
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+		return -1;
+	}
+
+	/**
+	 * Terminates the server.
+	 *
+	 * @return whether the server exited normally
+	 */
+	bool stop() {
+		if (m_pid <= 0) {
+			return false;
+		}
+		::kill(m_pid, SIGTERM);
+		int status;
+		::waitpid(m_pid, &status, 0);
+		m_pid = -1;
+		return WIFEXITED(status);
+	}
+};
+
+bool sendFrame(int fd, const std::string &payload)
+{
+	uint32_t length = htonl(static_cast<uint32_t>(payload.size()));
+	return ::write(fd, &length, sizeof(length)) == sizeof(length)
+		&& ::write(fd, payload.data(), payload.size())
+			== static_cast<ssize_t>(payload.size());
+}
+
+bool readBytes(int fd, char *buf, size_t length)
+{
+	while (length > 0) {
+		ssize_t n = ::read(fd, buf, length);
+		if (n <= 0) {
+			return false;
+		}
+		buf += n;
+		length -= n;
+	}
+	return true;
+}
+
+/**
+ * Reads a response frame.
+ *
+ * @return whether a complete frame was read
+ */
+bool receiveFrame(int fd, int &status, std::string &output)
+{
+	uint32_t length;
+	if (!readBytes(fd, reinterpret_cast<char*>(&length), sizeof(length))) {
+		return false;
+	}
+	length = ntohl(length);
+	std::string payload(length, '\0');
+	if (length == 0 || !readBytes(fd, &payload[0], length)) {
+		return false;
+	}
+	status = payload[0];
+	output = payload.substr(1);
+	return true;
+}
+
+/**
+ * @return content of the given file as a JSON string literal
+ */
+std::string networkString(const std::string &filename)
+{
+	std::ifstream f(resourcePath + "valid/" + filename + ".lgf");
+	REQUIRE(f);
+
+	std::string json = "\"";
+	char c;
+	while (f.get(c)) {
+		if (c == '\n') {
+			json += "\\n";
+		} else {
+			if (c == '"' || c == '\\') {
+				json += '\\';
+			}
+			json += c;
+		}
+	}
+	return json + "\"";
+}
+
+/**
+ * @param path path of a file
+ * @return whether the file exists
+ */
+bool fileExists(const std::string &path)
+{
+	struct stat st;
+	return ::stat(path.c_str(), &st) == 0;
+}
+
+TEST_CASE("Server","[server]") {
+	char netDirTemplate[] = "server_test.XXXXXX";
+	std::string netDir = ::mkdtemp(netDirTemplate);
+	ServerProcess server{netDir};
+	int fd = server.connect();
+	REQUIRE(fd >= 0);
+
+	std::string network = networkString("condition");
+	std::string recommend = "{\"action\":\"recommend\",\"recType\":\"active\","
+		"\"network\":" + network + ",";
+
+	int status;
+	std::string output;
+
+	SECTION("requests with mistyped elements are rejected") {
+		for (const char *members : {
+				"\"sections\":[5],\"conditions\":[],\"testGrades\":{}",
+				"\"sections\":[],\"conditions\":[5],\"testGrades\":{}",
+				"\"sections\":[],\"conditions\":[[5]],\"testGrades\":{}",
+				"\"sections\":[],\"conditions\":[],\"testGrades\":{\"1\":5}",
+				"\"sections\":[],\"conditions\":[],\"testGrades\":{},"
+					"\"nodeCosts\":[5]",
+				"\"sections\":[],\"conditions\":[],\"testGrades\":{},"
+					"\"nodeCosts\":[{\"weight\":\"1\",\"costs\":{}}]",
+				"\"sections\":[],\"conditions\":[],\"testGrades\":{},"
+					"\"nodeCosts\":[{\"weight\":1,\"costs\":[]}]",
+				"\"sections\":[],\"conditions\":[],\"testGrades\":{},"
+					"\"nodeCosts\":[{\"weight\":1,\"costs\":{\"1\":\"2\"}}]",
+				"\"sections\":[],\"conditions\":[],\"testGrades\":{},"
+					"\"nodePairCosts\":[{\"weight\":1,\"costs\":{\"1\":2}}]" }) {
+			REQUIRE(sendFrame(fd, recommend + members + "}"));
+			REQUIRE(receiveFrame(fd, status, output));
+			CHECK(status == EXIT_FAILURE);
+			CHECK(!output.empty());
+		}
+
+		// The connection is still answered afterwards.
+		REQUIRE(sendFrame(fd, "{\"action\":\"check\",\"network\":" + network + "}"));
+		REQUIRE(receiveFrame(fd, status, output));
+		CHECK(status == EXIT_SUCCESS);
+	}
+
+	SECTION("nets with test grades that are no numbers are rejected") {
+		std::string ungraded = networkString("test_simple");
+		ungraded.replace(ungraded.find("\\\"2\\\""), 5, "\\\"b\\\"");
+		REQUIRE(sendFrame(fd, "{\"action\":\"recommend\",\"recType\":\"active\","
+			"\"network\":" + ungraded + ",\"sections\":[],\"conditions\":[],"
+			"\"testGrades\":{\"128\":\"1\"}}"));
+		REQUIRE(receiveFrame(fd, status, output));
+		CHECK(status == EXIT_FAILURE);
+		CHECK(output.find("test id 128") != std::string::npos);
+
+		REQUIRE(sendFrame(fd, "{\"action\":\"check\",\"network\":" + ungraded + "}"));
+		REQUIRE(receiveFrame(fd, status, output));
+		CHECK(status == EXIT_FAILURE);
+		CHECK(output.find("test id 128 has a grade that is no number") != std::string::npos);
+	}
+
+	SECTION("requests that are too large are answered before closing") {
+		uint32_t length = htonl(0xffffffffu);
+		REQUIRE(::write(fd, &length, sizeof(length)) == sizeof(length));
+		REQUIRE(receiveFrame(fd, status, output));
+		CHECK(status == EXIT_FAILURE);
+		CHECK(output.find("too large") != std::string::npos);
+		CHECK(!receiveFrame(fd, status, output));
+	}
+
+	SECTION("network files are restricted to the network directory") {
+		std::string compile = "{\"action\":\"compile\",\"network\":" + network + ",";
+		for (const char *file : {"../escaped.lnb", "/tmp/escaped.lnb", "..", ""}) {
+			REQUIRE(sendFrame(fd, compile + "\"networkFile\":\"" + file + "\"}"));
+			REQUIRE(receiveFrame(fd, status, output));
+			CHECK(status == EXIT_FAILURE);
+		}
+		CHECK(!fileExists("escaped.lnb"));
+
+		REQUIRE(sendFrame(fd, compile + "\"networkFile\":\"net.lnb\"}"));
+		REQUIRE(receiveFrame(fd, status, output));
+		CHECK(status == EXIT_SUCCESS);
+		CHECK(fileExists(netDir + "/net.lnb"));
+
+		REQUIRE(sendFrame(fd, "{\"action\":\"recommend\",\"recType\":\"active\","
+			"\"networkFile\":\"net.lnb\",\"sections\":[],\"conditions\":[],"
+			"\"testGrades\":{}}"));
+		REQUIRE(receiveFrame(fd, status, output));
+		CHECK(status == EXIT_SUCCESS);
+		::unlink((netDir + "/net.lnb").c_str());
+	}
+
+	::close(fd);
+	CHECK(server.stop());
+	CHECK(::rmdir(netDir.c_str()) == 0);
+}
@@ -0,0 +1,53 @@
+#include <catch.hpp>
+#include <learningnet/SlicedCounters.hpp>
+#include <algorithm>
+
+using namespace learningnet;
+
+TEST_CASE("SlicedCounters","[join]") {
+	using Lanes = SlicedCounters::Lanes;
+	SlicedCounters counters{std::vector<int>{0, 1, 3, 6}};
+	for (int v = 0; v < 4; v++) {
+		CHECK(counters.atLeast(v, 0) == ~Lanes{0});
+		CHECK(counters.atLeast(v, 1) == 0);
+	}
+
+	SECTION("increment") {
+		counters.increment(2, 0b0110);
+		counters.increment(2, 0b1100);
+		counters.increment(3, 0b1);
+		CHECK(counters.get(2, 0) == 0);
+		CHECK(counters.get(2, 1) == 1);
+		CHECK(counters.get(2, 2) == 2);
+		CHECK(counters.get(2, 3) == 1);
+		CHECK(counters.get(3, 0) == 1);
+		CHECK(counters.get(1, 2) == 0);
+	}
+
+	SECTION("at least") {
+		// Lane i is incremented i times.
+		for (int k = 1; k <= 6; k++) {
+			counters.increment(3, ~Lanes{0} << k);
+		}
+		for (int k = 0; k <= 7; k++) {
+			for (int lane = 0; lane < SlicedCounters::LANE_COUNT; lane++) {
+				bool atLeast = (counters.atLeast(3, k) >> lane) & 1;
+				CHECK(atLeast == (std::min(lane, 6) >= k));
+			}
+		}
+
+		// Counters cannot exceed the largest value they were created for.
+		CHECK(counters.atLeast(3, 8) == 0);
+		CHECK(counters.atLeast(1, 2) == 0);
+	}
+
+	SECTION("reset") {
+		counters.increment(1, 0b11);
+		counters.increment(3, 0b10);
+		counters.reset();
+		CHECK(counters.atLeast(1, 1) == 0);
+		CHECK(counters.atLeast(3, 1) == 0);
+		counters.increment(1, 0b1);
+		CHECK(counters.atLeast(1, 1) == 0b1);
+	}
+}
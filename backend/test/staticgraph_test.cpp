@@ -0,0 +1,147 @@
+#include <catch.hpp>
+#include "resources.hpp"
+#include <learningnet/StaticGraph.hpp>
+
+using namespace learningnet;
+
+void checkStaticGraph(const LearningNet &net, const StaticGraph &graph)
+{
+	for (auto v : net.nodes()) {
+		int id = net.id(v);
+		CHECK(graph.inDegree(id) == countInArcs(net, v));
+		CHECK(graph.outDegree(id) == countOutArcs(net, v));
+
+		// Out-arcs are stored in the order of OutArcIt.
+		int i = graph.outBegin(id);
+		for (lemon::ListDigraph::OutArcIt a(net, v); a != lemon::INVALID; ++a) {
+			REQUIRE(i < graph.outEnd(id));
+			CHECK(graph.arc(i) == net.id(a));
+			CHECK(graph.target(i) == net.id(net.target(a)));
+			i++;
+		}
+		CHECK(i == graph.outEnd(id));
+	}
+}
+
+TEST_CASE("StaticGraph","[static]") {
+	SECTION("matches the net") {
+		for_each_file("valid", [](LearningNet &net) {
+			checkStaticGraph(net, *net.getStaticGraph());
+		});
+	}
+
+	SECTION("node records") {
+		for_each_file("valid", [](LearningNet &net) {
+			const StaticGraph &graph = *net.getStaticGraph();
+			for (auto v : net.nodes()) {
+				CHECK(graph.nodeClass(net.id(v)) == net.getClass(v));
+				if (net.isJoin(v)) {
+					CHECK(graph.ref(net.id(v)) == net.getNecessaryInArcs(v));
+				} else if (net.isCondition(v)) {
+					CHECK(graph.ref(net.id(v)) == net.getConditionId(v));
+				}
+			}
+		});
+
+		// The table classifies types as the ranges of NodeType do.
+		for (int type = -3; type < NodeType::join + 3; type++) {
+			uint8_t nodeClass = NodeClass::of(type);
+			CHECK(bool(nodeClass & NodeClass::unit) == (type < NodeType::split));
+			CHECK(bool(nodeClass & NodeClass::split) == (type == NodeType::split));
+			CHECK(bool(nodeClass & NodeClass::condition) == (type == NodeType::condition));
+			CHECK(bool(nodeClass & NodeClass::test) ==
+				(type >= NodeType::test && type < NodeType::join));
+			CHECK(bool(nodeClass & NodeClass::splitLike) ==
+				(type >= NodeType::split && type < NodeType::join));
+			CHECK(bool(nodeClass & NodeClass::join) == (type >= NodeType::join));
+			CHECK(bool(nodeClass & NodeClass::unknown) ==
+				(type < NodeType::inactive
+				 || (type > NodeType::completed && type < NodeType::split)
+				 || (type > NodeType::test && type < NodeType::join)));
+		}
+		static_assert(NodeClass::of(NodeType::condition) == NodeClass::condition,
+			"node types are classified at compile time");
+	}
+
+	SECTION("branch ids") {
+		for_each_file("valid", [](LearningNet &net) {
+			const StaticGraph &graph = *net.getStaticGraph();
+			for (auto a : net.arcs()) {
+				int branch = net.getConditionBranchId(a);
+				CHECK(net.getBranchName(branch) == net.getConditionBranch(a));
+				CHECK(net.getBranchId(net.getConditionBranch(a)) == branch);
+			}
+			for (auto v : net.nodes()) {
+				for (int i = graph.outBegin(net.id(v)); i < graph.outEnd(net.id(v)); i++) {
+					CHECK(graph.branch(i) ==
+						net.getConditionBranchId(net.arcFromId(graph.arc(i))));
+				}
+			}
+			CHECK(net.getBranchId("no branch of any net") == -1);
+		});
+
+		for_file("valid", "example_swe", [](LearningNet &net) {
+			lemon::ListDigraph::ArcIt a(net);
+			net.setConditionBranch(a, "new branch");
+			CHECK(net.getConditionBranch(a) == "new branch");
+			CHECK(net.getBranchName(net.getBranchId("new branch")) == "new branch");
+		});
+	}
+
+	SECTION("test grades") {
+		for_each_file("valid", [](LearningNet &net) {
+			const StaticGraph &graph = *net.getStaticGraph();
+			const GradeTable &grades = *net.getGradeTable();
+			for (auto v : net.nodes()) {
+				if (!net.isTest(v)) {
+					continue;
+				}
+				int id = net.id(v);
+				REQUIRE(grades.hasGrades(id));
+				ArrayView<GradedArc> arcs = grades.gradedArcs(id);
+				CHECK(static_cast<int>(arcs.size()) == graph.outDegree(id));
+				for (std::size_t i = 0; i < arcs.size(); i++) {
+					lemon::ListDigraph::Arc a = net.arcFromId(graph.arc(arcs[i].arc));
+					CHECK(arcs[i].grade == std::stoi(net.getConditionBranch(a)));
+					CHECK(net.isMaxGradeBranch(a) ==
+						(static_cast<int>(i) >= grades.maxGradeBegin(id)));
+					if (i > 0) {
+						CHECK(arcs[i - 1].grade <= arcs[i].grade);
+					}
+				}
+			}
+		});
+	}
+
+	SECTION("built anew after changes") {
+		for_file("valid", "example_swe", [](LearningNet &net) {
+			net.erase(net.getTarget());
+			lemon::ListDigraph::Node v = net.addNode();
+			net.setType(v, NodeType::inactive);
+			net.addArc(v, net.nodeFromId(0));
+
+			StaticGraph graph{net};
+			checkStaticGraph(net, graph);
+		});
+	}
+
+	SECTION("precomputed graph is discarded after changes") {
+		for_file("valid", "example_swe", [](LearningNet &net) {
+			REQUIRE(net.isPrecomputed());
+			std::shared_ptr<const StaticGraph> before = net.getStaticGraph();
+			int sources = net.getSources().size();
+
+			lemon::ListDigraph::Node v = net.addNode();
+			net.setType(v, NodeType::inactive);
+			net.addArc(v, net.getTarget());
+			CHECK(!net.isPrecomputed());
+			CHECK(static_cast<int>(net.getSources().size()) == sources + 1);
+			checkStaticGraph(net, *net.getStaticGraph());
+
+			net.precompute();
+			CHECK(net.isPrecomputed());
+			CHECK(net.getStaticGraph() != before);
+			checkStaticGraph(net, *net.getStaticGraph());
+		});
+	}
+}
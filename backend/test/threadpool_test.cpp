@@ -0,0 +1,98 @@
+#include <catch.hpp>
+#include <learningnet/ThreadPool.hpp>
+#include <filesystem>
+#include <stdexcept>
+
+using namespace learningnet;
+
+/**
+ * @return number of threads of this process
+ */
+std::size_t threadCount()
+{
+	std::size_t count = 0;
+	for (const auto &entry : std::filesystem::directory_iterator("/proc/self/task")) {
+		(void) entry;
+		count++;
+	}
+	return count;
+}
+
+TEST_CASE("ThreadPool","[pool]") {
+	for (unsigned int workers : {0u, 1u, 4u}) {
+		SECTION(std::to_string(workers) + " workers") {
+			ThreadPool pool{workers};
+
+			SECTION("every index is run once") {
+				std::vector<int> counts(1000, 0);
+				pool.parallelFor(counts.size(), [&counts](std::size_t i) {
+					counts[i]++;
+				});
+				for (int count : counts) {
+					CHECK(count == 1);
+				}
+			}
+
+			SECTION("nested calls do not block the workers") {
+				std::vector<std::vector<std::size_t>> results(16);
+				pool.parallelFor(results.size(), [&](std::size_t i) {
+					results[i].resize(64);
+					pool.parallelFor(results[i].size(), [&](std::size_t j) {
+						results[i][j] = i * j;
+					});
+				});
+				for (std::size_t i = 0; i < results.size(); i++) {
+					for (std::size_t j = 0; j < results[i].size(); j++) {
+						CHECK(results[i][j] == i * j);
+					}
+				}
+			}
+
+			SECTION("exception of the smallest index is rethrown") {
+				CHECK_THROWS_WITH(pool.parallelFor(100, [](std::size_t i) {
+					if (i % 10 == 3) {
+						throw std::runtime_error(std::to_string(i));
+					}
+				}), "3");
+			}
+
+			SECTION("async returns the result") {
+				CHECK(pool.async([]() { return 42; }).get() == 42);
+			}
+		}
+	}
+
+	SECTION("waiting threads only run calls of their own batch") {
+		ThreadPool pool{1};
+		std::promise<void> started, release;
+		std::future<void> releaseFuture = release.get_future();
+		pool.submit([&]() {
+			started.set_value();
+			releaseFuture.wait();
+		});
+		started.get_future().wait();
+
+		// Queued behind the blocked worker.
+		std::future<std::thread::id> other = pool.async([]() {
+			return std::this_thread::get_id();
+		});
+
+		std::vector<int> counts(8, 0);
+		pool.parallelFor(counts.size(), [&counts](std::size_t i) {
+			counts[i]++;
+		});
+		CHECK(counts == std::vector<int>(8, 1));
+
+		release.set_value();
+		CHECK(other.get() != std::this_thread::get_id());
+	}
+
+	SECTION("workers are started on the first submission") {
+		std::size_t threads = threadCount();
+		ThreadPool pool{4};
+		CHECK(pool.size() == 4);
+		CHECK(threadCount() == threads);
+		pool.parallelFor(8, [](std::size_t) {});
+		CHECK(threadCount() == threads + 4);
+	}
+}
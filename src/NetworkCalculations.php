@@ -26,20 +26,20 @@ class NetworkCalculations
     }
 
     /**
-     * Builds a shell command calling the backend executable with the JSON
-     * representation of the given arg.
+     * Builds a shell command calling the backend executable, which reads its
+     * JSON input from stdin.
      *
-     * @param mixed[] $arg array whose JSON representation is passed over to the
-     * backend executable
-     * @return string shell command calling the backend executable with $arg
+     * @return string shell command calling the backend executable
      */
-    private function buildCommand($arg)
+    private function buildCommand()
     {
-        return $this->executablePath . ' \'' . json_encode($arg) . '\' 2>&1';
+        return escapeshellarg($this->executablePath) . ' --stdin 2>&1';
     }
 
     /**
      * Runs the backend executable with the JSON representation of the given arg.
+     * The JSON is passed over stdin since large learning nets and cost tables
+     * exceed the maximum length of a command line argument.
      *
      * @param mixed[] $arg array whose JSON representation is passed over to the
      * backend executable
@@ -48,13 +48,27 @@ class NetworkCalculations
      */
     private function runCommand($arg)
     {
-        $output = [];
-        $returnVar = 0;
+        $descriptors = [
+            0 => ['pipe', 'r'],
+            1 => ['pipe', 'w']
+        ];
+        $process = proc_open($this->buildCommand(), $descriptors, $pipes);
+        if (!is_resource($process)) {
+            return [
+                'message' => 'The backend executable could not be started.',
+                'succeeded' => false
+            ];
+        }
+
+        fwrite($pipes[0], json_encode($arg));
+        fclose($pipes[0]);
 
-        exec($this->buildCommand($arg), $output, $returnVar);
+        $output = stream_get_contents($pipes[1]);
+        fclose($pipes[1]);
+        $returnVar = proc_close($process);
 
         return [
-            'message' => join("\n", $output),
+            'message' => rtrim($output, "\n"),
             'succeeded' => $returnVar === 0
         ];
     }